@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+
+// Process-wide heap counters, fed by the global operator new/delete
+// replacements in alloc_stats.cpp.
+struct AllocCounters {
+    size_t allocations = 0;
+    size_t frees = 0;
+    size_t bytes = 0;
+};
+
+AllocCounters allocCounters();
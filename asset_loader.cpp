@@ -0,0 +1,140 @@
+#include "asset_loader.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace {
+
+// Rows per band are picked so one band is about this many bytes.
+const size_t kBandBytes = 256 * 1024;
+
+}
+
+AssetLoader::AssetLoader(bool pbo, int threads) : usePbo(pbo) {
+    for (int i = 0; i < std::max(1, threads); ++i)
+        workers.emplace_back([this] { workerMain(); });
+}
+
+AssetLoader::~AssetLoader() {
+    {
+        std::lock_guard<std::mutex> lock(m);
+        quit = true;
+    }
+    cv.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+void AssetLoader::submit(std::function<bool(TextureUpload&)> decode) {
+    outstanding++;
+    {
+        std::lock_guard<std::mutex> lock(m);
+        decodes.push_back(std::move(decode));
+    }
+    cv.notify_one();
+}
+
+void AssetLoader::workerMain() {
+    profiler.setThreadName("asset loader");
+    for (;;) {
+        std::function<bool(TextureUpload&)> decode;
+        {
+            std::unique_lock<std::mutex> lock(m);
+            cv.wait(lock, [this] { return quit || !decodes.empty(); });
+            if (quit) return;
+            decode = std::move(decodes.front());
+            decodes.pop_front();
+        }
+        PROFILE_ZONE("asset decode");
+        TextureUpload upload;
+        bool ok = decode(upload) && upload.width > 0 && upload.height > 0 &&
+            upload.rgba.size() >= (size_t)upload.width * upload.height * 4;
+        if (!ok) {
+            outstanding--;
+            continue;
+        }
+        std::lock_guard<std::mutex> lock(m);
+        decoded.push_back(std::move(upload));
+    }
+}
+
+bool AssetLoader::idle() const {
+    return outstanding.load() == 0;
+}
+
+// Uploads the next band of the active texture; true once it is complete.
+bool AssetLoader::uploadBand() {
+    const size_t rowBytes = (size_t)active.width * 4;
+    int rows = std::max(1, (int)(kBandBytes / rowBytes));
+    rows = std::min(rows, active.height - nextRow);
+    size_t bytes = rowBytes * rows;
+    const unsigned char* src = active.rgba.data() + rowBytes * nextRow;
+
+    glBindTexture(GL_TEXTURE_2D, activeTex);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    if (usePbo) {
+        if (!pbo) glGenBuffers(1, &pbo);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+        // Orphaned every band, so the copy never waits for the previous transfer.
+        pboBytes = std::max(pboBytes, bytes);
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, pboBytes, nullptr, GL_STREAM_DRAW);
+        void* dst = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (dst) {
+            std::memcpy(dst, src, bytes);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, nextRow, active.width, rows, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        if (!dst) {
+            // Mapping failed; fall back to plain uploads from here on.
+            usePbo = false;
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, nextRow, active.width, rows, GL_RGBA, GL_UNSIGNED_BYTE, src);
+        }
+    }
+    else {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, nextRow, active.width, rows, GL_RGBA, GL_UNSIGNED_BYTE, src);
+    }
+    uploadedBytes += bytes;
+    nextRow += rows;
+    if (nextRow < active.height) return false;
+
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, active.maxLevel);
+    if (active.maxLevel > 0) glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, active.maxLevel > 0 ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    return true;
+}
+
+void AssetLoader::pump(double budgetMillis) {
+    PROFILE_ZONE("asset upload");
+    typedef std::chrono::steady_clock Clock;
+    auto t0 = Clock::now();
+    bool worked = false;
+    do {
+        if (!uploading) {
+            {
+                std::lock_guard<std::mutex> lock(m);
+                if (decoded.empty()) break;
+                active = std::move(decoded.front());
+                decoded.pop_front();
+            }
+            glGenTextures(1, &activeTex);
+            glBindTexture(GL_TEXTURE_2D, activeTex);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, active.width, active.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+            nextRow = 0;
+            uploading = true;
+        }
+        worked = true;
+        if (uploadBand()) {
+            uploading = false;
+            texturesReady++;
+            if (active.onReady) active.onReady(activeTex);
+            active = TextureUpload();
+            outstanding--;
+        }
+    } while (std::chrono::duration<double, std::milli>(Clock::now() - t0).count() < budgetMillis);
+    if (worked) pumpsUploading++;
+}
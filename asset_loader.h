@@ -0,0 +1,68 @@
+#pragma once
+
+#include <glad.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Pixels decoded off the main thread, waiting to become a texture.
+struct TextureUpload {
+    int width = 0, height = 0;
+    int maxLevel = 0;   // mip levels generated once the last row is in
+    std::vector<unsigned char> rgba;
+    // Called on the main thread with the finished texture.
+    std::function<void(GLuint)> onReady;
+};
+
+// Decodes assets on worker threads and turns them into textures on the main
+// thread. pump() uploads a band of rows at a time, through a pixel buffer
+// object when enabled, and stops once its per-frame budget is spent, so a
+// large texture is spread over several frames instead of stalling one.
+class AssetLoader {
+public:
+    explicit AssetLoader(bool usePbo = true, int threads = 1);
+    ~AssetLoader();
+
+    AssetLoader(const AssetLoader&) = delete;
+    AssetLoader& operator=(const AssetLoader&) = delete;
+
+    // Runs `decode` on a worker; if it returns true, the upload it filled in
+    // is queued for pump().
+    void submit(std::function<bool(TextureUpload&)> decode);
+
+    // Main thread only. Always makes some progress when there is work.
+    void pump(double budgetMillis);
+
+    // Nothing decoding, queued or half uploaded.
+    bool idle() const;
+
+    size_t uploadedBytes = 0;
+    int texturesReady = 0;
+    int pumpsUploading = 0;   // frames that spent time on uploads
+
+private:
+    void workerMain();
+    bool uploadBand();
+
+    std::vector<std::thread> workers;
+    mutable std::mutex m;
+    std::condition_variable cv;
+    std::deque<std::function<bool(TextureUpload&)>> decodes;
+    std::deque<TextureUpload> decoded;
+    std::atomic<int> outstanding{ 0 };   // submitted and not yet ready
+    bool quit = false;
+
+    bool usePbo;
+    GLuint pbo = 0;
+    size_t pboBytes = 0;
+    bool uploading = false;
+    TextureUpload active;
+    GLuint activeTex = 0;
+    int nextRow = 0;
+};
@@ -0,0 +1,1158 @@
+#include "alloc_stats.h"
+#include "bench.h"
+#include "brick_grid.h"
+#include "brick_store.h"
+#include "collision.h"
+#include "font.h"
+#include "frame_arena.h"
+#include "frame_renderer.h"
+#include "game_world.h"
+#include "job_system.h"
+#include "level.h"
+#include "particles.h"
+#include "profiler.h"
+#include "render_device.h"
+#include "render_queue.h"
+#include "replay.h"
+#include "rng.h"
+#include "sprite_batch.h"
+#include "vec_env.h"
+
+#include <glm.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double secondsSince(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+// How often the scheduler has taken the CPU away from this thread. Where
+// that cannot be asked, it stays 0 and nothing is excused.
+long involuntarySwitches() {
+#ifdef __linux__
+    rusage ru;
+    if (getrusage(RUSAGE_THREAD, &ru) == 0) return ru.ru_nivcsw;
+#endif
+    return 0;
+}
+
+struct BenchBall {
+    glm::vec2 pos;
+    glm::vec2 vel;
+    float radius;
+};
+
+// Lays out `count` bricks in rows the way main() does, widening the field
+// rather than shrinking the bricks so density stays realistic.
+std::vector<BrickBounds> makeBrickField(int count, glm::vec2& fieldSize) {
+    const float brickW = 70.0f, brickH = 30.0f, margin = 10.0f, rowGap = 20.0f;
+    int cols = std::max(10, (int)std::sqrt((float)count * 2.0f));
+    int rows = (count + cols - 1) / cols;
+    fieldSize = glm::vec2(margin + cols * (brickW + margin), rowGap + rows * (brickH + rowGap));
+
+    std::vector<BrickBounds> bricks;
+    for (int i = 0; i < count; ++i) {
+        int r = i / cols, c = i % cols;
+        BrickBounds b;
+        b.min = glm::vec2(margin + c * (brickW + margin), fieldSize.y - (r + 1) * (brickH + rowGap));
+        b.max = b.min + glm::vec2(brickW, brickH);
+        bricks.push_back(b);
+    }
+    return bricks;
+}
+
+int benchBroadphase() {
+    const int brickCounts[] = { 50, 1000, 50000 };
+    const int ballCount = 64;
+    const int frames = 600;
+    const float dt = 1.0f / 60.0f;
+
+    std::printf("%8s %14s %14s %10s\n", "bricks", "linear ns/ball", "grid ns/ball", "speedup");
+    for (int count : brickCounts) {
+        glm::vec2 field;
+        std::vector<BrickBounds> bricks = makeBrickField(count, field);
+
+        std::mt19937 rng(1234);
+        std::uniform_real_distribution<float> ux(0.0f, field.x), uy(0.0f, field.y), uv(-400.0f, 400.0f);
+        std::vector<char> alive(bricks.size(), 1);
+        for (size_t i = 0; i < alive.size(); ++i)
+            if (rng() % 2) alive[i] = 0;
+
+        BrickGrid grid;
+        grid.build(bricks, BrickGrid::suggestCellSize(bricks));
+        for (size_t i = 0; i < alive.size(); ++i)
+            if (!alive[i]) grid.remove((int)i);
+
+        std::vector<BenchBall> start;
+        for (int i = 0; i < ballCount; ++i)
+            start.push_back({ glm::vec2(ux(rng), uy(rng)), glm::vec2(uv(rng), uv(rng)), 10.0f });
+
+        auto wrap = [&](BenchBall& b) {
+            if (b.pos.x < 0 || b.pos.x > field.x) b.vel.x = -b.vel.x;
+            if (b.pos.y < 0 || b.pos.y > field.y) b.vel.y = -b.vel.y;
+        };
+
+        long long linearHits = 0, gridHits = 0;
+        glm::vec2 closest;
+
+        std::vector<BenchBall> balls = start;
+        auto t0 = Clock::now();
+        for (int f = 0; f < frames; ++f) {
+            for (auto& ball : balls) {
+                ball.pos += ball.vel * dt;
+                wrap(ball);
+                for (size_t i = 0; i < bricks.size(); ++i) {
+                    if (!alive[i]) continue;
+                    if (AABBvsCircle(bricks[i].min, bricks[i].max - bricks[i].min, ball.pos, ball.radius, closest)) {
+                        linearHits += i + 1;
+                        break;
+                    }
+                }
+            }
+        }
+        double linearTime = secondsSince(t0);
+
+        balls = start;
+        std::vector<int> candidates;
+        t0 = Clock::now();
+        for (int f = 0; f < frames; ++f) {
+            for (auto& ball : balls) {
+                glm::vec2 prev = ball.pos;
+                ball.pos += ball.vel * dt;
+                wrap(ball);
+                candidates.clear();
+                grid.query(glm::min(prev, ball.pos) - glm::vec2(ball.radius),
+                    glm::max(prev, ball.pos) + glm::vec2(ball.radius), candidates);
+                for (int i : candidates) {
+                    if (AABBvsCircle(bricks[i].min, bricks[i].max - bricks[i].min, ball.pos, ball.radius, closest)) {
+                        gridHits += i + 1;
+                        break;
+                    }
+                }
+            }
+        }
+        double gridTime = secondsSince(t0);
+
+        if (linearHits != gridHits) {
+            std::printf("mismatch at %d bricks: linear %lld vs grid %lld\n", count, linearHits, gridHits);
+            return 1;
+        }
+        double queries = (double)frames * ballCount;
+        std::printf("%8d %14.1f %14.1f %9.1fx\n", count,
+            linearTime * 1e9 / queries, gridTime * 1e9 / queries, linearTime / gridTime);
+    }
+    return 0;
+}
+
+// Scalar AABBvsCircle over every brick against the SoA SIMD kernel, for
+// circles of a ball's size and for the large enclosing circles fast balls use.
+int benchSimd() {
+    const int brickCounts[] = { 50, 1000, 50000 };
+    const int queries = 20000;
+
+    std::printf("kernel isa: %s\n", circleOverlapIsa());
+    std::printf("%8s %8s %16s %16s %10s\n", "bricks", "radius", "scalar ns/query", "simd ns/query", "speedup");
+    for (int count : brickCounts) {
+        glm::vec2 field;
+        std::vector<BrickBounds> layout = makeBrickField(count, field);
+        BrickStore store;
+        for (const auto& b : layout)
+            store.add(b.min, b.max - b.min, glm::vec4(1.0f));
+
+        std::mt19937 rng(42);
+        for (size_t i = 0; i < store.count(); ++i)
+            if (rng() % 4 == 0) store.kill(i);
+
+        std::uniform_real_distribution<float> ux(0.0f, field.x), uy(0.0f, field.y);
+        std::vector<glm::vec2> centres;
+        for (int i = 0; i < queries; ++i)
+            centres.push_back(glm::vec2(ux(rng), uy(rng)));
+
+        std::vector<uint32_t> out(store.paddedCount());
+        const float radii[] = { 10.0f, 200.0f };
+        for (float radius : radii) {
+            int n = std::max(1, queries * 50 / count);
+            long long scalarSum = 0, simdSum = 0;
+
+            auto t0 = Clock::now();
+            for (int q = 0; q < n; ++q) {
+                size_t hits = circleOverlapScalar(store, 0, store.count(), centres[q % queries], radius, out.data());
+                for (size_t h = 0; h < hits; ++h) scalarSum += out[h] + 1;
+            }
+            double scalarTime = secondsSince(t0);
+
+            t0 = Clock::now();
+            for (int q = 0; q < n; ++q) {
+                size_t hits = circleOverlapBatch(store, 0, store.count(), centres[q % queries], radius, out.data());
+                for (size_t h = 0; h < hits; ++h) simdSum += out[h] + 1;
+            }
+            double simdTime = secondsSince(t0);
+
+            if (scalarSum != simdSum) {
+                std::printf("mismatch at %d bricks, radius %g\n", count, radius);
+                return 1;
+            }
+            std::printf("%8d %8g %16.1f %16.1f %9.1fx\n", count, radius,
+                scalarTime * 1e9 / n, simdTime * 1e9 / n, scalarTime / simdTime);
+        }
+    }
+    return 0;
+}
+
+// Paddle follows the lowest ball, which keeps a game alive long enough to
+// exercise brick hits, power-ups and multiball.
+GameInput autopilot(const GameWorld& world) {
+    GameInput input;
+    input.paddleX = world.paddle.pos.x + world.paddle.size.x * 0.5f;
+    float lowest = 1e30f;
+    for (const auto& ball : world.balls) {
+        if (ball.pos.y < lowest) {
+            lowest = ball.pos.y;
+            input.paddleX = ball.pos.x;
+        }
+    }
+    return input;
+}
+
+int benchWorld() {
+    const long long steps = 2000000;
+    const float dt = 1.0f / 240.0f;
+
+    GameWorld world;
+    long long games = 0, maxBalls = 0;
+    auto t0 = Clock::now();
+    for (long long i = 0; i < steps; ++i) {
+        world.step(dt, autopilot(world));
+        maxBalls = std::max(maxBalls, (long long)world.balls.size());
+        if (world.gameOver || world.youWin) {
+            world.reset();
+            games++;
+        }
+    }
+    double t = secondsSince(t0);
+    std::printf("%lld steps in %.3f s: %.2f M steps/s (%lld games, peak %lld balls)\n",
+        steps, t, steps / t / 1e6, games, maxBalls);
+    return 0;
+}
+
+// Plays games on autopilot and builds the render queue every frame the way
+// main() does, counting heap allocations made while stepping and while
+// building the queue. Level setup between games is not counted.
+int checkFrameAllocs() {
+    const int frames = 200000;
+    const int warmup = 120;
+    const float dt = 1.0f / 240.0f;
+    GameWorld world;
+    FrameArena arena;
+    RenderQueue queue;
+    SpriteSkin skin;
+    size_t renderAllocs = 0, simAllocs = 0, dirtyFrames = 0;
+    int games = 0;
+    for (int f = 0; f < frames; ++f) {
+        arena.reset();
+        AllocCounters a0 = allocCounters();
+        for (int i = 0; i < 4; ++i) world.step(dt, autopilot(world));
+        AllocCounters a1 = allocCounters();
+        queueWorld(world, 0.5f, skin, arena, queue);
+        AllocCounters a2 = allocCounters();
+
+        if (world.gameOver || world.youWin) {
+            world.reset();
+            games++;
+        }
+        if (f < warmup) continue;
+        simAllocs += a1.allocations - a0.allocations;
+        size_t n = a2.allocations - a1.allocations;
+        renderAllocs += n;
+        if (n) dirtyFrames++;
+    }
+    std::printf("%d frames, %d games: %zu render-queue allocations (%zu frames), %zu simulation allocations, "
+        "arena peak %zu bytes\n", frames - warmup, games, renderAllocs, dirtyFrames, simAllocs, arena.highWater());
+    return renderAllocs == 0 && simAllocs == 0 ? 0 : 1;
+}
+
+// Draw throughput of the C library generator against the per-world PCG32,
+// plus a check that two streams from one seed do not track each other.
+int benchRng() {
+    const int n = 20000000;
+    std::vector<uint32_t> out(n);
+    long long sink = 0;
+
+    srand(1);
+    auto t0 = Clock::now();
+    for (int i = 0; i < n; ++i) sink += rand() % 90;
+    double crtTime = secondsSince(t0);
+
+    Pcg32 rng(1);
+    t0 = Clock::now();
+    for (int i = 0; i < n; ++i) sink += rng.bounded(90);
+    double pcgTime = secondsSince(t0);
+
+    t0 = Clock::now();
+    rng.fillBounded(out.data(), n, 90);
+    double fillTime = secondsSince(t0);
+    for (uint32_t v : out) sink += v;
+
+    std::printf("%-22s %8.2f ns/draw\n", "rand() % 90", crtTime * 1e9 / n);
+    std::printf("%-22s %8.2f ns/draw\n", "Pcg32::bounded(90)", pcgTime * 1e9 / n);
+    std::printf("%-22s %8.2f ns/draw\n", "Pcg32::fillBounded", fillTime * 1e9 / n);
+
+    Pcg32 a(42, 0), b(42, 1);
+    int same = 0;
+    for (int i = 0; i < 1000000; ++i) same += a.next() == b.next();
+    Pcg32 child = a.split();
+    int sameSplit = 0;
+    for (int i = 0; i < 1000000; ++i) sameSplit += a.next() == child.next();
+    std::printf("equal draws in 1M: streams 0/1 %d, parent/split %d (checksum %lld)\n", same, sameSplit, sink);
+    return same < 10 && sameSplit < 10 ? 0 : 1;
+}
+
+// Environment steps per second for a batch of worlds, on one thread and on
+// the whole job system. Every fourth env keeps its paddle away from the
+// ball, so episodes end and get reset during the run; the rest track the
+// lowest ball, a little off centre.
+// Both batches are stepped in lockstep on the same actions, and their
+// observations, rewards and dones must match after every step.
+int benchVecEnv() {
+    const int sizes[] = { 256, 4096 };
+    const int calls = 1200;
+    JobSystem jobs;
+    std::printf("threads: %d\n", jobs.threadCount());
+    std::printf("    envs  threads   env-steps/s   sim-steps/s  episodes\n");
+    bool same = true, finished = true;
+    for (int n : sizes) {
+        VecEnvConfig cfg;
+        cfg.numEnvs = n;
+        VecEnv serial(cfg), parallel(cfg, &jobs);
+        std::vector<float> actions(n);
+        Pcg32 rng(11);
+        double serialTime = 0.0, parallelTime = 0.0;
+        int mismatchAt = -1;
+        for (int c = 0; c < calls; ++c) {
+            const float* ballX = serial.observations() + VecEnv::OBS_BALL_X * n;
+            for (int i = 0; i < n; ++i)
+                actions[i] = i % 4 == 0 ? std::fmod(ballX[i] + 0.5f, 1.0f) : ballX[i] + rng.range(-0.05f, 0.05f);
+            auto t0 = Clock::now();
+            serial.step(actions.data());
+            serialTime += secondsSince(t0);
+            t0 = Clock::now();
+            parallel.step(actions.data());
+            parallelTime += secondsSince(t0);
+
+            const size_t obsCount = (size_t)VecEnv::OBS_COUNT * n;
+            bool match = std::equal(serial.observations(), serial.observations() + obsCount, parallel.observations()) &&
+                std::equal(serial.rewards(), serial.rewards() + n, parallel.rewards()) &&
+                std::equal(serial.dones(), serial.dones() + n, parallel.dones());
+            if (!match && mismatchAt < 0) mismatchAt = c;
+        }
+        double envSteps = (double)n * calls;
+        std::printf("%8d %8d %13.0f %13.0f %9lld\n", n, 1,
+            envSteps / serialTime, envSteps * cfg.stepsPerAction / serialTime, serial.episodes());
+        std::printf("%8d %8d %13.0f %13.0f %9lld\n", n, jobs.threadCount(),
+            envSteps / parallelTime, envSteps * cfg.stepsPerAction / parallelTime, parallel.episodes());
+        if (mismatchAt >= 0) std::printf("MISMATCH between serial and job system at step %d\n", mismatchAt);
+        same = same && mismatchAt < 0 && serial.episodes() == parallel.episodes();
+        finished = finished && serial.episodes() > 0;
+    }
+    if (!finished) std::printf("no episode finished, so auto-reset went untested\n");
+    return same && finished ? 0 : 1;
+}
+
+// Fills a particle system past 100k live debris particles and times the
+// integrate-and-cull kernel against its scalar version, instance writing, and
+// how well update() keeps to its CPU budget when bursts keep coming.
+int benchParticles() {
+    const size_t target = 100000;
+    const float dt = 1.0f / 60.0f;
+    const int frames = 300;
+
+    ParticleConfig config;
+    config.budgetMicros = 1e9;
+    config.burstQueue = 1024;
+    ParticleSystem unbounded(config, 7);
+    for (int i = 0; i < 120; ++i)
+        unbounded.emit(glm::vec2(400.0f, 300.0f), glm::vec4(0.9f, 0.4f, 0.2f, 1.0f), 1000, 300.0f, 60.0f);
+    unbounded.update(0.0f);
+    size_t peak = unbounded.liveCount();
+
+    std::vector<SpriteInstance> instances(config.capacity);
+    double updateTime = 0.0, writeTime = 0.0;
+    for (int f = 0; f < frames; ++f) {
+        auto t0 = Clock::now();
+        unbounded.update(dt);
+        updateTime += secondsSince(t0);
+        t0 = Clock::now();
+        unbounded.writeInstances(instances.data(), glm::vec4(0.0f, 0.0f, 1.0f, 1.0f));
+        writeTime += secondsSince(t0);
+        peak = std::max(peak, unbounded.liveCount());
+    }
+    double live = (double)unbounded.liveCount();
+    std::printf("live particles: %zu (peak %zu), kernel %s\n", unbounded.liveCount(), peak, particleKernelIsa());
+    std::printf("%-22s %8.3f ms/frame %6.2f ns/particle\n", "update", updateTime * 1e3 / frames, updateTime * 1e9 / frames / live);
+    std::printf("%-22s %8.3f ms/frame %6.2f ns/particle\n", "writeInstances", writeTime * 1e3 / frames, writeTime * 1e9 / frames / live);
+
+    // Same particles through both kernels, with a third of them expiring mid-run.
+    ParticleSoA a, b;
+    a.resize(config.capacity);
+    Pcg32 rng(3);
+    for (size_t i = 0; i < target; ++i) {
+        a.posX[i] = rng.range(0.0f, 800.0f); a.posY[i] = rng.range(0.0f, 600.0f);
+        a.velX[i] = rng.range(-200.0f, 200.0f); a.velY[i] = rng.range(-200.0f, 200.0f);
+        a.life[i] = rng.range(0.0f, 3.0f * frames * dt); a.invMaxLife[i] = 1.0f;
+        a.r[i] = a.g[i] = a.b[i] = (float)i;
+    }
+    b = a;
+    size_t na = target, nb = target;
+    double simdTime = 0.0, scalarTime = 0.0;
+    for (int f = 0; f < frames; ++f) {
+        auto t0 = Clock::now();
+        na = integrateParticles(a, na, dt, config.gravity);
+        simdTime += secondsSince(t0);
+        t0 = Clock::now();
+        nb = integrateParticlesScalar(b, nb, dt, config.gravity);
+        scalarTime += secondsSince(t0);
+    }
+    bool same = na == nb;
+    for (size_t i = 0; same && i < na; ++i)
+        same = a.posX[i] == b.posX[i] && a.posY[i] == b.posY[i] && a.life[i] == b.life[i] && a.r[i] == b.r[i];
+    std::printf("%-22s %8.3f ms total (%zu left)\n", "integrate scalar", scalarTime * 1e3, nb);
+    std::printf("%-22s %8.3f ms total (%zu left) %.2fx, %s\n", "integrate simd", simdTime * 1e3, na,
+        scalarTime / simdTime, same ? "identical" : "MISMATCH");
+
+    // A budget half of what integrating a full million-particle system costs
+    // here, so update() has to cut the integrate short. Every frame must stay
+    // within it, give or take 5% for the clock and for interrupts taken in
+    // the middle of the last slice. A frame in which the thread was switched
+    // out is reported but not held to the budget; no budget survives that.
+    ParticleConfig budgeted;
+    budgeted.capacity = 1 << 20;
+    double fullMicros = simdTime * 1e6 / frames / target * budgeted.capacity;
+    budgeted.budgetMicros = std::floor(fullMicros * 0.5);
+    const double marginMicros = budgeted.budgetMicros * 0.05;
+    ParticleSystem bounded(budgeted, 7);
+    double worst = 0.0, total = 0.0;
+    size_t minLimit = budgeted.capacity;
+    int over = 0, preempted = 0;
+    for (int f = 0; f < frames; ++f) {
+        for (int k = 0; k < 40; ++k)
+            bounded.emit(glm::vec2(400.0f, 300.0f), glm::vec4(1.0f), 500, 300.0f, 60.0f);
+        long switches = involuntarySwitches();
+        bounded.update(dt);
+        bool switchedOut = involuntarySwitches() != switches;
+        total += bounded.lastUpdateMicros();
+        worst = std::max(worst, bounded.lastUpdateMicros());
+        minLimit = std::min(minLimit, bounded.liveLimit());
+        if (bounded.lastUpdateMicros() > budgeted.budgetMicros + marginMicros) {
+            if (switchedOut) preempted++;
+            else over++;
+        }
+    }
+    std::printf("budget %.0f us: mean update %.0f us, worst %.0f us, %d frames over (%d more preempted), live %zu, lowest limit %zu, dropped %zu\n",
+        budgeted.budgetMicros, total / frames, worst, over, preempted, bounded.liveCount(), minLimit,
+        bounded.droppedParticles());
+    bool limited = minLimit < budgeted.capacity;
+    bool inBudget = over == 0 && limited;
+    if (!inBudget) std::printf("OVER BUDGET%s\n", limited ? "" : " (integrate never cut short)");
+    return peak >= target && same && inBudget ? 0 : 1;
+}
+
+GameWorld multiballWorld(int count, uint64_t seed) {
+    WorldConfig config;
+    config.rows = 20;
+    config.cols = 40;
+    config.maxBalls = 2048;
+    GameWorld world(config);
+    world.lives = 1000000;
+    world.balls.clear();
+    Pcg32 rng(seed);
+    for (int i = 0; i < count; ++i) {
+        Ball ball;
+        ball.radius = 4.0f;
+        ball.pos = ball.prevPos = glm::vec2(rng.range(20.0f, 780.0f), rng.range(100.0f, 200.0f));
+        ball.vel = glm::vec2(rng.range(-300.0f, 300.0f), rng.range(200.0f, 600.0f));
+        world.balls.spawn(ball);
+    }
+    return world;
+}
+
+// Heavy multiball: steps the same world with serial and with parallel contact
+// detection and requires identical state after every step. Then steps several
+// such worlds at once on the job system, each detecting in parallel too, so
+// parallelFor runs inside parallelFor.
+int benchBalls() {
+    const int counts[] = { 64, 256, 1024 };
+    const int steps = 600;
+    const float dt = 1.0f / 240.0f;
+    JobSystem jobs;
+    std::printf("threads: %d\n", jobs.threadCount());
+    std::printf("   balls   serial us/step   parallel us/step   speedup\n");
+    for (int count : counts) {
+        GameWorld base = multiballWorld(count, count);
+        GameWorld serial = base, parallel = base;
+        parallel.jobs = &jobs;
+        double serialTime = 0.0, parallelTime = 0.0;
+        for (int s = 0; s < steps; ++s) {
+            GameInput input = autopilot(serial);
+            auto t0 = Clock::now();
+            serial.step(dt, input);
+            serialTime += secondsSince(t0);
+            t0 = Clock::now();
+            parallel.step(dt, input);
+            parallelTime += secondsSince(t0);
+            if (serial.stateHash() != parallel.stateHash()) {
+                std::printf("balls: parallel run diverged at step %d with %d balls\n", s, count);
+                return 1;
+            }
+        }
+        std::printf("%8d %16.1f %18.1f %8.2fx\n", count, serialTime * 1e6 / steps, parallelTime * 1e6 / steps,
+            serialTime / parallelTime);
+    }
+
+    // Four threads whatever the machine, so there are workers to nest on.
+    JobSystem nestedJobs(4);
+    std::vector<GameWorld> reference, nested;
+    for (int w = 0; w < 8; ++w) {
+        reference.push_back(multiballWorld(256, 100 + w));
+        nested.push_back(reference.back());
+        nested.back().jobs = &nestedJobs;
+    }
+    std::vector<GameInput> inputs(reference.size());
+    for (int s = 0; s < steps / 4; ++s) {
+        for (size_t w = 0; w < reference.size(); ++w) {
+            inputs[w] = autopilot(reference[w]);
+            reference[w].step(dt, inputs[w]);
+        }
+        nestedJobs.parallelFor(nested.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t w = begin; w < end; ++w) nested[w].step(dt, inputs[w]);
+        });
+        for (size_t w = 0; w < reference.size(); ++w) {
+            if (reference[w].stateHash() != nested[w].stateHash()) {
+                std::printf("balls: nested parallel run of world %zu diverged at step %d\n", w, s);
+                return 1;
+            }
+        }
+    }
+    std::printf("%zu worlds stepped in parallel with parallel detection: identical to serial\n", nested.size());
+    return 0;
+}
+
+// Compiles a 50,000 brick level, writes it out and times mapping it against
+// parsing the source and against filling a BrickStore brick by brick.
+int benchLevel() {
+    const int cols = 250, rows = 200;
+    const char* path = "bench_level.lvb";
+    std::string text = "size 20010 12010\nkey A ff4d4d\nkey B 4d8cff 3\nkey C ffe14d 1 multiball\n"
+        "grid 10 12000 70 30 10 20\n";
+    for (int r = 0; r < rows; ++r) {
+        text += "row ";
+        for (int c = 0; c < cols; ++c) text += "ABCA"[(r + c) % 4];
+        text += "\n";
+    }
+
+    std::vector<uint8_t> bytes;
+    std::string error;
+    auto t0 = Clock::now();
+    if (!compileLevel(text, bytes, error)) {
+        std::printf("level: %s\n", error.c_str());
+        return 1;
+    }
+    double compileTime = secondsSince(t0);
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write((const char*)bytes.data(), bytes.size());
+    }
+
+    t0 = Clock::now();
+    std::shared_ptr<const Level> level = Level::open(path, error);
+    double openTime = secondsSince(t0);
+    if (!level) {
+        std::printf("level: %s\n", error.c_str());
+        return 1;
+    }
+    t0 = Clock::now();
+    bool verified = level->verify(error);
+    double verifyTime = secondsSince(t0);
+
+    BrickStore attached;
+    t0 = Clock::now();
+    attached.attach(level->bricks(), level);
+    double attachTime = secondsSince(t0);
+
+    const BrickArrays& a = level->bricks();
+    BrickStore added;
+    t0 = Clock::now();
+    for (size_t i = 0; i < a.count; ++i)
+        added.add(glm::vec2(a.minX[i], a.minY[i]), glm::vec2(a.maxX[i] - a.minX[i], a.maxY[i] - a.minY[i]),
+            a.color[i], a.row[i], a.hitPoints[i], a.drop[i]);
+    double addTime = secondsSince(t0);
+
+    WorldConfig config;
+    config.width = level->header().width;
+    config.height = level->header().height;
+    config.level = level;
+    t0 = Clock::now();
+    GameWorld world(config);
+    double worldTime = secondsSince(t0);
+
+    bool same = added.count() == attached.count() && added.liveCount() == attached.liveCount() &&
+        added.laneMask == attached.laneMask && added.hitPoints == attached.hitPoints;
+    for (size_t i = 0; same && i < added.count(); ++i)
+        same = added.pos(i) == attached.pos(i) && added.extent(i) == attached.extent(i) && added.row[i] == attached.row[i];
+    // The row index built incrementally by add() and in one go by attach().
+    for (float y = -50.0f; same && y < config.height + 50.0f; y += 7.0f)
+        same = added.liveRowsOverlap(y, y + 12.0f) == attached.liveRowsOverlap(y, y + 12.0f);
+
+    std::printf("%zu bricks, %zu byte level file, mapped: %s\n", a.count, bytes.size(), level->mapped() ? "yes" : "no");
+    std::printf("%-26s %9.3f ms\n", "compile source", compileTime * 1e3);
+    std::printf("%-26s %9.3f ms\n", "open (map + header)", openTime * 1e3);
+    std::printf("%-26s %9.3f ms %s\n", "verify (checksum, bricks)", verifyTime * 1e3, verified ? "ok" : error.c_str());
+    std::printf("%-26s %9.3f ms\n", "BrickStore::attach", attachTime * 1e3);
+    std::printf("%-26s %9.3f ms\n", "BrickStore::add each", addTime * 1e3);
+    std::printf("%-26s %9.3f ms (includes the grid)\n", "GameWorld from level", worldTime * 1e3);
+    std::printf("attached store %s the added one\n", same ? "matches" : "DIFFERS from");
+
+    // The mapping has to go before the file can be removed on Windows.
+    size_t count = a.count;
+    world = GameWorld();
+    level.reset();
+    attached.clear();
+    std::remove(path);
+    return verified && same && count == (size_t)cols * rows ? 0 : 1;
+}
+
+// A font with a box for every glyph, standing in for arial.ttf so text
+// costs what it does in the game.
+void adoptBoxFont(Font& font, GLuint texture) {
+    FontBitmap bitmap;
+    bitmap.height = 48.0f;
+    bitmap.ascent = 36.0f;
+    bitmap.descent = -12.0f;
+    bitmap.glyphs.resize(kLastChar - kFirstChar + 1);
+    for (Glyph& g : bitmap.glyphs) {
+        g.size = glm::vec2(24.0f, 36.0f);
+        g.advance = 26.0f;
+    }
+    bitmap.glyphs[0].size = glm::vec2(0.0f);   // space
+    font.adopt(std::move(bitmap), texture);
+}
+
+// Runs main()'s per-frame render path, FrameRenderer::submit with the F3
+// overlay up, against `device` on autopilot games, four steps a frame.
+// `counters` are those of the device the calls end up at. Returns the
+// seconds spent submitting, the most draws a frame took, and the most it
+// took beyond one per pass and texture.
+double submitFrames(RenderDevice& device, const DeviceCounters& counters, int frames, long long& maxDraws,
+    long long& maxExtraDraws)
+{
+    const GLuint spriteProgram = 1, rectProgram = 2;
+    const GLuint quadVAO = 1, brickVAO = 2, particleVAO = 3, rectVAO = 4;
+    const float dt = 1.0f / 240.0f;
+    SpriteSkin skin;
+    skin.tex = 1;
+    Font font;
+    adoptBoxFont(font, 2);
+    // No time budget, so the debris (and the command stream) is the same every run.
+    ParticleConfig particleConfig;
+    particleConfig.budgetMicros = 1e9;
+
+    GameWorld world;
+    ParticleSystem particles(particleConfig, 7);
+    FrameArena arena;
+    RenderQueue queue;
+    FrameRenderer renderer;
+    renderer.init(device, spriteProgram, rectProgram, quadVAO, brickVAO, particleVAO, rectVAO,
+        (int)particleConfig.capacity);
+    renderer.bricks.upload(world.bricks, skin);
+    // The profiler is off here, so the overlay is just its header.
+    ProfilerOverlay overlay;
+    overlay.refresh(font);
+    const std::string fpsText = "FPS 60";
+    FrameScene scene;
+    scene.world = &world;
+    scene.queue = &queue;
+    scene.particles = &particles;
+    scene.skin = skin;
+    scene.font = &font;
+    scene.fpsText = &fpsText;
+    scene.overlay = &overlay;
+
+    double seconds = 0.0;
+    maxDraws = maxExtraDraws = 0;
+    for (int f = 0; f < frames; ++f) {
+        arena.reset();
+        for (int i = 0; i < 4; ++i) {
+            world.step(dt, autopilot(world));
+            auto t0 = Clock::now();
+            renderer.bricks.patch(world.bricks, world.killedBricks);
+            seconds += secondsSince(t0);
+            for (int brick : world.killedBricks)
+                particles.emit(world.bricks.pos(brick) + world.bricks.extent(brick) * 0.5f, world.bricks.color[brick], 48);
+        }
+        particles.update(1.0f / 60.0f);
+        queueWorld(world, 0.5f, skin, arena, queue);
+
+        long long draws = counters.draws();
+        auto t0 = Clock::now();
+        renderer.submit(scene);
+        seconds += secondsSince(t0);
+        // Bricks, particles, sprites and HUD text, the overlay's rects and
+        // text, and the banner's when it is up.
+        bool banner = world.gameOver || world.youWin;
+        long long expected = 4 + 2 + (banner ? 2 : 0);
+        maxDraws = std::max(maxDraws, counters.draws() - draws);
+        maxExtraDraws = std::max(maxExtraDraws, counters.draws() - draws - expected);
+
+        if (banner) {
+            world.reset();
+            renderer.bricks.upload(world.bricks, skin);
+        }
+    }
+    return seconds;
+}
+
+// Submission cost of the render path with no GPU, on the GL 3.3 and the
+// persistently mapped stream paths and behind the state cache, and a check
+// that a frame takes no more than one draw per pass and texture and that it
+// submits the same commands on every run. Behind the cache nothing redundant should get
+// through, while the draws stay as they were.
+// Writes into a persistent mapping never reach the device, so that path
+// shows no bytes.
+int benchSubmit() {
+    const int frames = 20000;
+    bool ok = true;
+
+    std::printf("%-22s %9s %9s %9s %9s %9s %9s\n", "device", "us/frame", "calls", "redundant", "filtered",
+        "KiB", "max draws");
+    long long uncachedInstances = 0;
+    for (int run = 0; run < 3; ++run) {
+        const bool persistent = run == 1, cached = run == 2;
+        NullRenderDevice null(persistent);
+        CachingRenderDevice cache(null);
+        RenderDevice& device = cached ? (RenderDevice&)cache : null;
+        long long maxDraws = 0, extraDraws = 0;
+        submitFrames(device, null.counters, 60, maxDraws, extraDraws);   // creation and first uploads
+        null.counters.reset();
+        cache.resetCounters();
+        double t = submitFrames(device, null.counters, frames, maxDraws, extraDraws);
+        const DeviceCounters& c = null.counters;
+        const char* label = cached ? "cached, map per write" : persistent ? "null, persistent map" : "null, map per write";
+        std::printf("%-22s %9.2f %9.1f %9.1f %9.1f %9.1f %9lld\n", label, t * 1e6 / frames,
+            (double)c.total() / frames, (double)c.redundant / frames, (double)cache.filteredTotal() / frames,
+            c.bytes / 1024.0 / frames, maxDraws);
+        ok = ok && extraDraws <= 0;
+        if (run == 0) uncachedInstances = c.instances;
+        if (cached) {
+            std::printf("filtered per frame:");
+            for (int op = 0; op < OP_COUNT; ++op)
+                if (cache.filtered[op] > 0)
+                    std::printf(" %s %.1f", renderOpName((RenderOp)op), (double)cache.filtered[op] / frames);
+            std::printf("\n");
+            ok = ok && c.redundant == 0 && c.instances == uncachedInstances;
+        }
+    }
+
+    CaptureRenderDevice first, second;
+    long long maxDraws = 0, extraDraws = 0;
+    submitFrames(first, first.counters, 600, maxDraws, extraDraws);
+    submitFrames(second, second.counters, 600, maxDraws, extraDraws);
+    bool same = first.text() == second.text();
+    std::printf("capture: %zu commands over 600 frames, second run %s\n", first.commands.size(),
+        same ? "identical" : "DIFFERS");
+    std::printf("per frame:");
+    for (int op = 0; op < OP_COUNT; ++op)
+        if (first.counters.calls[op] >= 600)
+            std::printf(" %s %.1f", renderOpName((RenderOp)op), first.counters.calls[op] / 600.0);
+    std::printf("\n");
+    return ok && same ? 0 : 1;
+}
+
+// Counts the texture binds a batch needs to draw `n` sprites in this order.
+int textureSwitches(const Sprite* const* order, int n) {
+    int switches = 0;
+    for (int i = 0; i < n; ++i)
+        if (i == 0 || order[i]->tex != order[i - 1]->tex) switches++;
+    return switches;
+}
+
+// Orders a frame of random sprites (four textures, eight depths, a third of
+// them transparent) three ways, each including building the lists: the old
+// way, opaque sprites in push order and transparent ones by std::sort on
+// depth; by key with std::stable_sort; and by key with the queue's radix
+// sort. Fails if the queue's order differs from the stable sort, if an
+// opaque sprite follows a transparent one, or if transparent sprites stop
+// going back to front.
+int benchQueue() {
+    const int sizes[] = { 16, 256, 2048, 4096, 65536 };
+    const int perSize = 1 << 21;
+    bool ok = true;
+    std::mt19937 rng(3);
+
+    std::printf("%8s %14s %14s %14s %13s %12s\n", "sprites", "old us", "keys sort us", "queue us", "binds before",
+        "binds keyed");
+    for (int n : sizes) {
+        std::vector<Sprite> input(n);
+        for (Sprite& sp : input) {
+            sp.pos = glm::vec2((float)(rng() % 800), (float)(rng() % 600));
+            sp.size = glm::vec2(16.0f);
+            sp.tex = 1 + rng() % 4;
+            sp.transparent = rng() % 3 == 0;
+            sp.depth = (float)(rng() % 8) * 0.5f;
+        }
+        const int reps = perSize / n;
+
+        std::vector<Sprite> opaque, transparent;
+        opaque.reserve(n);
+        transparent.reserve(n);
+        auto t0 = Clock::now();
+        for (int r = 0; r < reps; ++r) {
+            opaque.clear();
+            transparent.clear();
+            for (const Sprite& sp : input) (sp.transparent ? transparent : opaque).push_back(sp);
+            std::sort(transparent.begin(), transparent.end(), [](const Sprite& a, const Sprite& b) {
+                if (a.depth != b.depth) return a.depth > b.depth;
+                return a.pos.y > b.pos.y;
+                });
+        }
+        double oldTime = secondsSince(t0);
+        std::vector<const Sprite*> order;
+        for (const Sprite& sp : opaque) order.push_back(&sp);
+        for (const Sprite& sp : transparent) order.push_back(&sp);
+        int oldSwitches = textureSwitches(order.data(), n);
+
+        FrameArena arena(n * (sizeof(Sprite) + 2 * sizeof(RenderItem)) + 1024);
+        RenderQueue queue;
+        t0 = Clock::now();
+        for (int r = 0; r < reps; ++r) {
+            arena.reset();
+            queue.begin(arena, n);
+            for (const Sprite& sp : input) queue.push(sp);
+            queue.sort();
+        }
+        double keyedTime = secondsSince(t0);
+        order.clear();
+        for (int i = 0; i < queue.count; ++i) order.push_back(&queue[i]);
+        int keyedSwitches = textureSwitches(order.data(), n);
+
+        std::vector<RenderItem> expected(n);
+        auto byKey = [](const RenderItem& a, const RenderItem& b) { return a.key < b.key; };
+        t0 = Clock::now();
+        for (int r = 0; r < reps; ++r) {
+            for (int i = 0; i < n; ++i) {
+                const Sprite& sp = input[i];
+                expected[i] = { renderKey(sp.transparent ? PASS_TRANSPARENT : PASS_OPAQUE, sp.depth, 0, sp.tex, 0), i };
+            }
+            std::stable_sort(expected.begin(), expected.end(), byKey);
+        }
+        double keysTime = secondsSince(t0);
+        for (int i = 0; i < n; ++i) {
+            ok = ok && queue.items[i].sprite == expected[i].sprite;
+            if (i == 0) continue;
+            const Sprite& a = queue[i - 1];
+            const Sprite& b = queue[i];
+            ok = ok && !(a.transparent && !b.transparent);
+            ok = ok && !(a.transparent && b.transparent && a.depth < b.depth);
+        }
+
+        std::printf("%8d %14.2f %14.2f %14.2f %13d %12d\n", n, oldTime * 1e6 / reps, keysTime * 1e6 / reps,
+            keyedTime * 1e6 / reps, oldSwitches, keyedSwitches);
+    }
+    std::printf("keyed order %s\n", ok ? "verified" : "WRONG");
+    return ok ? 0 : 1;
+}
+
+// Cost of a zone with the profiler off and on (including the per-frame
+// drain), then zones from a job pool and a trace of them.
+int benchProfiler() {
+    const int zones = 1 << 20;
+    const int perFrame = 4096;
+    volatile int sink = 0;
+
+    profiler.enable(false);
+    auto t0 = Clock::now();
+    for (int i = 0; i < zones; ++i) {
+        PROFILE_ZONE("bench zone");
+        sink = sink + 1;
+    }
+    double offTime = secondsSince(t0);
+
+    profiler.enable(true);
+    t0 = Clock::now();
+    for (int i = 0; i < zones; ++i) {
+        PROFILE_ZONE("bench zone");
+        sink = sink + 1;
+        if ((i + 1) % perFrame == 0) profiler.endFrame();
+    }
+    double onTime = secondsSince(t0);
+    const ZoneStats* z = profiler.zone("bench zone");
+    int zoneCalls = z ? z->lastCalls : 0;
+
+    std::printf("ARK_PROFILE=%d\n", ARK_PROFILE);
+    std::printf("%-22s %7.1f ns\n", "zone, profiler off", offTime * 1e9 / zones);
+    std::printf("%-22s %7.1f ns\n", "zone, profiler on", onTime * 1e9 / zones);
+    if (z)
+        std::printf("%d zones per frame: mean %.1f us, p95 %.1f us, max %.1f us\n", z->lastCalls, z->mean(),
+            z->percentile(0.95f), z->max());
+
+    // Every chunk is one zone, whichever thread runs it.
+    const size_t items = 1 << 16, grain = 64;
+    const char* path = "bench_trace.json";
+    JobSystem jobs(8);
+    profiler.startTrace(path, 2);
+    int traced = 0;
+    for (int frame = 0; frame < 2; ++frame) {
+        jobs.parallelFor(items, grain, [&](size_t begin, size_t end) {
+            PROFILE_ZONE("bench job");
+            volatile size_t local = 0;
+            for (size_t i = begin; i < end; ++i) local = local + i;
+        });
+        profiler.endFrame();
+        const ZoneStats* job = profiler.zone("bench job");
+        traced += job ? job->lastCalls : 0;
+    }
+    int written = 0;
+    std::ifstream trace(path);
+    for (std::string line; std::getline(trace, line);)
+        written += line.find("\"bench job\"") != std::string::npos;
+    trace.close();
+    std::remove(path);
+
+    bool ok = ARK_PROFILE == 0 || (zoneCalls == perFrame && traced == (int)(2 * items / grain) &&
+        written == traced && profiler.droppedEvents() == 0);
+    std::printf("%d job zones over %d threads, %d in the trace, %llu dropped\n", traced, jobs.threadCount(),
+        written, (unsigned long long)profiler.droppedEvents());
+    return ok ? 0 : 1;
+}
+
+// Records an autopilot session, round-trips it through the binary format and
+// plays it back; then shifts two seconds of input and expects the hashes to
+// catch it.
+int checkReplay() {
+    const int steps = 500000;
+    WorldConfig config;
+    config.seed = 12345;
+    GameWorld world(config);
+    ReplayRecorder recorder;
+    recorder.begin(config, 240.0);
+    for (int i = 0; i < steps && !world.gameOver && !world.youWin; ++i) {
+        // Hold the paddle still between moves, the way a mouse does between polls.
+        GameInput input;
+        input.paddleX = std::floor(autopilot(world).paddleX / 8.0f) * 8.0f;
+        world.step(1.0f / 240.0f, input);
+        recorder.record(input, world);
+    }
+
+    std::vector<uint8_t> bytes;
+    encodeReplay(recorder.replay(), bytes);
+    Replay decoded;
+    if (!decodeReplay(bytes.data(), bytes.size(), decoded) || decoded.inputs != recorder.replay().inputs) {
+        std::printf("replay: round trip through the binary format failed\n");
+        return 1;
+    }
+    ReplayResult r = playReplay(decoded);
+    double gameSeconds = r.steps / decoded.simHz;
+    std::printf("%lld steps (%.0f s of play) in %zu bytes (%.2f bytes/step), played back in %.3f s, %.0fx real time\n",
+        r.steps, gameSeconds, bytes.size(), (double)bytes.size() / r.steps, r.seconds, gameSeconds / r.seconds);
+    if (r.mismatchStep >= 0 || r.finalHash != world.stateHash()) {
+        std::printf("replay: playback diverged after step %lld\n", r.mismatchStep);
+        return 1;
+    }
+
+    Replay tampered = decoded;
+    size_t from = tampered.inputs.size() / 2;
+    for (size_t i = from; i < std::min(from + 480, tampered.inputs.size()); ++i) tampered.inputs[i] += 300.0f;
+    ReplayResult t = playReplay(tampered);
+    if (t.mismatchStep < 0) {
+        std::printf("replay: changed input went unnoticed\n");
+        return 1;
+    }
+    std::printf("input changed from step %zu detected after step %lld\n", from, t.mismatchStep);
+
+    // Damaged files, as a bug report might bring them, must be turned away
+    // before they allocate anything or reach GameWorld.
+    auto varint = [](std::vector<uint8_t>& out, uint64_t v) {
+        for (; v >= 0x80; v >>= 7) out.push_back((uint8_t)(v | 0x80));
+        out.push_back((uint8_t)v);
+    };
+    Replay empty;
+    empty.hashInterval = 1;
+    std::vector<uint8_t> header;
+    encodeReplay(empty, header);
+    header.resize(header.size() - 2);   // the zero step and hash counts
+    std::vector<std::vector<uint8_t>> damaged(4, header);
+    varint(damaged[0], 1ull << 62);   // one run of 2^62 steps
+    varint(damaged[0], 1ull << 62);
+    damaged[0].insert(damaged[0].end(), 4, 0);
+    varint(damaged[1], 1 << 20);   // a million steps, then a million hashes that are not there
+    varint(damaged[1], 1 << 20);
+    damaged[1].insert(damaged[1].end(), 4, 0);
+    varint(damaged[1], 1 << 20);
+    Replay badRows, badBalls;
+    badRows.config.rows = -5;
+    badBalls.config.maxBalls = 1 << 30;
+    encodeReplay(badRows, damaged[2]);
+    encodeReplay(badBalls, damaged[3]);
+    int rejected = 0;
+    for (const auto& file : damaged) {
+        Replay out;
+        rejected += !decodeReplay(file.data(), file.size(), out);
+    }
+    std::printf("damaged replays rejected: %d of %zu\n", rejected, damaged.size());
+    return rejected == (int)damaged.size() ? 0 : 1;
+}
+
+GameWorld worldWithBall(glm::vec2 pos, glm::vec2 vel) {
+    GameWorld world;
+    world.lives = 1000000;
+    Ball ball;
+    ball.radius = 10.0f;
+    ball.pos = ball.prevPos = pos;
+    ball.vel = vel;
+    world.balls.clear();
+    world.balls.spawn(ball);
+    return world;
+}
+
+// First brick a ball touches when marched along a straight line in tiny
+// increments; an independent reference for the swept test.
+int marchFirstHit(const GameWorld& world, glm::vec2 p, glm::vec2 d, float r, glm::vec2& hitPos) {
+    float len = glm::length(d);
+    int samples = std::max(1, (int)(len / 0.05f));
+    glm::vec2 closest;
+    for (int i = 0; i <= samples; ++i) {
+        glm::vec2 q = p + d * ((float)i / samples);
+        const BrickStore& bricks = world.bricks;
+        for (size_t b = 0; b < bricks.count(); ++b) {
+            if (bricks.isAlive(b) && AABBvsCircle(bricks.pos(b), bricks.extent(b), q, r, closest)) {
+                hitPos = q;
+                return (int)b;
+            }
+        }
+    }
+    return -1;
+}
+
+// Fires balls at extreme speeds with a large timestep and checks that the
+// swept collision never lets them through a brick or the paddle.
+int checkCcd() {
+    const float speeds[] = { 1e3f, 1e4f, 1e5f, 1e6f };
+    const float dt = 1.0f / 30.0f;
+    int failures = 0, cases = 0;
+
+    for (float speed : speeds) {
+        for (int deg = 60; deg <= 120; deg += 5) {
+            float a = deg * 3.14159265f / 180.0f;
+            glm::vec2 start(400.0f, 120.0f), vel(std::cos(a) * speed, std::sin(a) * speed);
+            GameWorld world = worldWithBall(start, vel);
+            glm::vec2 hitPos;
+            int expected = marchFirstHit(world, start, vel * dt, 10.0f, hitPos);
+
+            GameInput input;
+            input.paddleX = 100.0f;
+            world.step(dt, input);
+            cases++;
+
+            int got = world.killedBricks.empty() ? -1 : world.killedBricks[0];
+            bool ok = got == expected;
+            if (!ok && got >= 0 && expected >= 0) {
+                // Equal-time touches of two neighbouring bricks may resolve either way.
+                glm::vec2 closest;
+                ok = AABBvsCircle(world.bricks.pos(got), world.bricks.extent(got), hitPos + glm::normalize(vel) * 0.1f, 10.0f, closest);
+            }
+            if (!ok) {
+                std::printf("brick sweep: speed %g angle %d hit %d, expected %d\n", speed, deg, got, expected);
+                failures++;
+            }
+        }
+    }
+
+    for (float speed : speeds) {
+        GameWorld world = worldWithBall(glm::vec2(300.0f, 150.0f), glm::vec2(0.0f, -speed));
+        GameInput input;
+        input.paddleX = 300.0f;
+        world.step(dt, input);
+        cases++;
+        float paddleTop = world.paddle.pos.y + world.paddle.size.y;
+        if (world.balls.size() != 1 || world.balls.begin()->pos.y - world.balls.begin()->radius < paddleTop - 0.01f) {
+            std::printf("paddle sweep: speed %g went through the paddle\n", speed);
+            failures++;
+        }
+    }
+
+    // Soak: many fast balls, large steps, and no ball may end a step inside a
+    // live brick or outside the walls.
+    std::mt19937 rng(99);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f), speed(5e3f, 2e5f);
+    for (int round = 0; round < 200; ++round) {
+        GameWorld world = worldWithBall(glm::vec2(400.0f, 200.0f), glm::vec2(0.0f));
+        world.balls.clear();
+        for (int i = 0; i < 32; ++i) {
+            float a = angle(rng), v = speed(rng);
+            Ball ball;
+            ball.radius = 10.0f;
+            ball.pos = ball.prevPos = glm::vec2(100.0f + 20.0f * i, 150.0f + 2.0f * i);
+            ball.vel = glm::vec2(std::cos(a) * v, std::sin(a) * v);
+            world.balls.spawn(ball);
+        }
+        for (int stepIndex = 0; stepIndex < 20 && !world.balls.empty(); ++stepIndex) {
+            GameInput input;
+            input.paddleX = world.balls.begin()->pos.x;
+            world.step(dt, input);
+            cases++;
+            for (const auto& ball : world.balls) {
+                bool bad = !(ball.pos.x >= ball.radius - 0.01f && ball.pos.x <= 800.0f - ball.radius + 0.01f &&
+                    ball.pos.y <= 600.0f - ball.radius + 0.01f);
+                glm::vec2 closest;
+                const BrickStore& bricks = world.bricks;
+                for (size_t b = 0; b < bricks.count(); ++b)
+                    if (bricks.isAlive(b) && AABBvsCircle(bricks.pos(b), bricks.extent(b), ball.pos, ball.radius - 0.01f, closest))
+                        bad = true;
+                if (bad) {
+                    std::printf("soak: round %d step %d ball at (%.2f, %.2f) escaped or penetrated\n",
+                        round, stepIndex, ball.pos.x, ball.pos.y);
+                    failures++;
+                    break;
+                }
+            }
+        }
+    }
+
+    std::printf("ccd: %d cases, %d failures\n", cases, failures);
+    return failures == 0 ? 0 : 1;
+}
+
+}
+
+int runBenchmark(const std::string& name) {
+    if (name == "broadphase") return benchBroadphase();
+    if (name == "world") return benchWorld();
+    if (name == "ccd") return checkCcd();
+    if (name == "simd") return benchSimd();
+    if (name == "alloc") return checkFrameAllocs();
+    if (name == "replay") return checkReplay();
+    if (name == "rng") return benchRng();
+    if (name == "vecenv") return benchVecEnv();
+    if (name == "balls") return benchBalls();
+    if (name == "particles") return benchParticles();
+    if (name == "level") return benchLevel();
+    if (name == "profiler") return benchProfiler();
+    if (name == "submit") return benchSubmit();
+    if (name == "queue") return benchQueue();
+
+    std::printf("unknown benchmark '%s'\navailable: broadphase, world, ccd, simd, alloc, replay, rng, vecenv, balls, particles, level, profiler, submit, queue\n", name.c_str());
+    return 1;
+}
@@ -0,0 +1,7 @@
+#pragma once
+
+#include <string>
+
+// Headless benchmarks, run with `creative --bench <name>` before any window
+// or GL context is created. Returns the process exit code.
+int runBenchmark(const std::string& name);
@@ -0,0 +1,114 @@
+#include "brick_grid.h"
+
+#include <algorithm>
+#include <cmath>
+
+float BrickGrid::suggestCellSize(const std::vector<BrickBounds>& bricks) {
+    if (bricks.empty()) return 64.0f;
+    float sum = 0.0f;
+    for (const auto& b : bricks)
+        sum += std::max(b.max.x - b.min.x, b.max.y - b.min.y);
+    return std::max(sum / bricks.size(), 1.0f);
+}
+
+void BrickGrid::cellRange(const glm::vec2& lo, const glm::vec2& hi, int& x0, int& y0, int& x1, int& y1) const {
+    x0 = std::max(0, (int)std::floor((lo.x - origin.x) * invCell));
+    y0 = std::max(0, (int)std::floor((lo.y - origin.y) * invCell));
+    x1 = std::min(cols - 1, (int)std::floor((hi.x - origin.x) * invCell));
+    y1 = std::min(rows - 1, (int)std::floor((hi.y - origin.y) * invCell));
+}
+
+int BrickGrid::cellsCovered(const glm::vec2& lo, const glm::vec2& hi) const {
+    if (cols == 0) return 0;
+    int x0, y0, x1, y1;
+    cellRange(lo, hi, x0, y0, x1, y1);
+    if (x1 < x0 || y1 < y0) return 0;
+    return (x1 - x0 + 1) * (y1 - y0 + 1);
+}
+
+void BrickGrid::build(const std::vector<BrickBounds>& bricks, float cellSize) {
+    bounds = bricks;
+    firstCellX.assign(bricks.size(), 0);
+    firstCellY.assign(bricks.size(), 0);
+    items.clear();
+    cols = rows = 0;
+    if (bricks.empty()) {
+        cellStart.assign(1, 0);
+        cellCount.clear();
+        return;
+    }
+
+    glm::vec2 lo = bricks[0].min, hi = bricks[0].max;
+    for (const auto& b : bricks) {
+        lo = glm::min(lo, b.min);
+        hi = glm::max(hi, b.max);
+    }
+    origin = lo;
+    invCell = 1.0f / cellSize;
+    cols = std::max(1, (int)std::ceil((hi.x - lo.x) * invCell));
+    rows = std::max(1, (int)std::ceil((hi.y - lo.y) * invCell));
+
+    // Two passes: count per cell, then scatter into the prefix-summed slices.
+    cellCount.assign(cols * rows, 0);
+    for (const auto& b : bricks) {
+        int x0, y0, x1, y1;
+        cellRange(b.min, b.max, x0, y0, x1, y1);
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x)
+                cellCount[y * cols + x]++;
+    }
+    cellStart.assign(cols * rows + 1, 0);
+    for (int c = 0; c < cols * rows; ++c)
+        cellStart[c + 1] = cellStart[c] + cellCount[c];
+
+    items.resize(cellStart.back());
+    std::fill(cellCount.begin(), cellCount.end(), 0);
+    for (int i = 0; i < (int)bricks.size(); ++i) {
+        int x0, y0, x1, y1;
+        cellRange(bricks[i].min, bricks[i].max, x0, y0, x1, y1);
+        firstCellX[i] = x0;
+        firstCellY[i] = y0;
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x) {
+                int c = y * cols + x;
+                items[cellStart[c] + cellCount[c]++] = i;
+            }
+    }
+}
+
+void BrickGrid::remove(int brick) {
+    if (brick < 0 || brick >= (int)bounds.size()) return;
+    int x0, y0, x1, y1;
+    cellRange(bounds[brick].min, bounds[brick].max, x0, y0, x1, y1);
+    for (int y = y0; y <= y1; ++y)
+        for (int x = x0; x <= x1; ++x) {
+            int c = y * cols + x;
+            int* first = &items[cellStart[c]];
+            int* last = first + cellCount[c];
+            int* it = std::find(first, last, brick);
+            if (it == last) continue;
+            *it = *(last - 1);
+            cellCount[c]--;
+        }
+}
+
+void BrickGrid::query(const glm::vec2& lo, const glm::vec2& hi, std::vector<int>& out) const {
+    if (cols == 0) return;
+
+    size_t first = out.size();
+    int x0, y0, x1, y1;
+    cellRange(lo, hi, x0, y0, x1, y1);
+    for (int y = y0; y <= y1; ++y)
+        for (int x = x0; x <= x1; ++x) {
+            int c = y * cols + x;
+            for (int k = cellStart[c], end = cellStart[c] + cellCount[c]; k < end; ++k) {
+                int b = items[k];
+                // A brick spanning several cells is reported only from the
+                // first of them inside the query, so no per-query dedup state
+                // is needed and concurrent queries are safe.
+                if (std::max(firstCellX[b], x0) != x || std::max(firstCellY[b], y0) != y) continue;
+                out.push_back(b);
+            }
+        }
+    std::sort(out.begin() + first, out.end());
+}
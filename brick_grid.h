@@ -0,0 +1,41 @@
+#pragma once
+
+#include <glm.hpp>
+
+#include <vector>
+
+struct BrickBounds {
+    glm::vec2 min;
+    glm::vec2 max;
+};
+
+// Static uniform grid over the brick field. Built once per level; bricks are
+// only ever removed, so every cell keeps a fixed slice of `items` and just
+// shrinks its live count.
+class BrickGrid {
+public:
+    void build(const std::vector<BrickBounds>& bricks, float cellSize);
+    void remove(int brick);
+
+    // Appends every live brick whose cells overlap [lo, hi], each once and in
+    // ascending index order so results match a linear scan. Safe to call from
+    // several threads at once.
+    void query(const glm::vec2& lo, const glm::vec2& hi, std::vector<int>& out) const;
+
+    // Number of cells a query over [lo, hi] would visit.
+    int cellsCovered(const glm::vec2& lo, const glm::vec2& hi) const;
+
+    static float suggestCellSize(const std::vector<BrickBounds>& bricks);
+
+private:
+    void cellRange(const glm::vec2& lo, const glm::vec2& hi, int& x0, int& y0, int& x1, int& y1) const;
+
+    glm::vec2 origin = glm::vec2(0.0f);
+    float invCell = 1.0f;
+    int cols = 0, rows = 0;
+    std::vector<int> cellStart;
+    std::vector<int> cellCount;
+    std::vector<int> items;
+    std::vector<BrickBounds> bounds;
+    std::vector<int> firstCellX, firstCellY;   // lowest cell each brick touches
+};
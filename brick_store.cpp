@@ -0,0 +1,367 @@
+#include "brick_store.h"
+#include "collision.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ARK_X86 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define ARK_TARGET(isa)
+#else
+#define ARK_TARGET(isa) __attribute__((target(isa)))
+#endif
+
+const size_t BrickStore::kBrickLanes;
+const uint8_t BrickStore::kDropRoll, BrickStore::kDropType, BrickStore::kDropNever;
+
+void BrickStore::clear() {
+    minX = minY = maxX = maxY = nullptr;
+    color = nullptr;
+    row = nullptr;
+    drop = nullptr;
+    owned.reset();
+    backing.reset();
+    laneMask.clear();
+    hitPoints.clear();
+    rowLive.clear();
+    rowBits.clear();
+    rowMinY.clear();
+    rowMaxY.clear();
+    bottomUpTo.clear();
+    topFrom.clear();
+    padded = n = live = liveChunks = 0;
+}
+
+void BrickStore::bindOwned() {
+    minX = owned->minX.data(); minY = owned->minY.data();
+    maxX = owned->maxX.data(); maxY = owned->maxY.data();
+    color = owned->color.data();
+    row = owned->row.data();
+    drop = owned->drop.data();
+}
+
+// Copy on write: the arrays may be shared with copies of this store or live
+// in a mapped level.
+void BrickStore::makeOwned() {
+    if (owned && owned.use_count() == 1) return;
+    auto copy = std::make_shared<Owned>();
+    copy->minX.assign(minX, minX + padded); copy->minY.assign(minY, minY + padded);
+    copy->maxX.assign(maxX, maxX + padded); copy->maxY.assign(maxY, maxY + padded);
+    copy->color.assign(color, color + padded);
+    copy->row.assign(row, row + padded);
+    copy->drop.assign(drop, drop + padded);
+    owned = copy;
+    backing.reset();
+    bindOwned();
+}
+
+int BrickStore::add(const glm::vec2& pos, const glm::vec2& size, const glm::vec4& c, int brickRow,
+    int hp, uint8_t dropKind)
+{
+    makeOwned();
+    Owned& o = *owned;
+    size_t need = (n + 1 + kBrickLanes - 1) / kBrickLanes * kBrickLanes;
+    if (need > padded) {
+        padded = need;
+        o.minX.resize(padded, 0.0f); o.minY.resize(padded, 0.0f);
+        o.maxX.resize(padded, 0.0f); o.maxY.resize(padded, 0.0f);
+        o.color.resize(padded, glm::vec4(0.0f));
+        o.row.resize(padded, 0);
+        o.drop.resize(padded, kDropNever);
+        laneMask.resize(padded / kBrickLanes, 0);
+        hitPoints.resize(padded, 0);
+        bindOwned();
+    }
+    if (brickRow >= (int)rowLive.size()) growRows(brickRow + 1);
+    o.minX[n] = pos.x; o.minY[n] = pos.y;
+    o.maxX[n] = pos.x + size.x; o.maxY[n] = pos.y + size.y;
+    o.color[n] = c;
+    o.row[n] = brickRow;
+    o.drop[n] = dropKind;
+    laneMask[n / kBrickLanes] |= (uint16_t)(1u << (n % kBrickLanes));
+    hitPoints[n] = (uint8_t)std::min(std::max(hp, 1), 255);
+    rowLive[brickRow]++;
+    rowBits[brickRow / 64] |= 1ull << (brickRow % 64);
+    extendRow(brickRow, pos.y, pos.y + size.y);
+    live++;
+    liveChunks = n / kBrickLanes + 1;
+    return (int)n++;
+}
+
+void BrickStore::attach(const BrickArrays& a, std::shared_ptr<const void> owner) {
+    clear();
+    backing = std::move(owner);
+    minX = a.minX; minY = a.minY; maxX = a.maxX; maxY = a.maxY;
+    color = a.color;
+    row = a.row;
+    drop = a.drop;
+    n = a.count;
+    padded = a.padded;
+
+    // The mutable state is all that gets built: a copy of the hit points, the
+    // occupancy bits and the row extents.
+    hitPoints.assign(a.hitPoints, a.hitPoints + padded);
+    laneMask.assign(padded / kBrickLanes, 0);
+    for (size_t chunk = 0; chunk * kBrickLanes < n; ++chunk) {
+        size_t lanes = std::min(kBrickLanes, n - chunk * kBrickLanes);
+        laneMask[chunk] = (uint16_t)((1u << lanes) - 1);
+    }
+    growRows(a.rows);
+    std::copy(a.rowCounts, a.rowCounts + a.rows, rowLive.begin());
+    for (int r = 0; r < a.rows; ++r)
+        if (rowLive[r] > 0) rowBits[r / 64] |= 1ull << (r % 64);
+    for (size_t i = 0; i < n; ++i) {
+        rowMinY[row[i]] = std::min(rowMinY[row[i]], minY[i]);
+        rowMaxY[row[i]] = std::max(rowMaxY[row[i]], maxY[i]);
+    }
+    for (int r = 0; r < a.rows; ++r)
+        bottomUpTo[r] = std::min(r > 0 ? bottomUpTo[r - 1] : rowMinY[r], rowMinY[r]);
+    for (int r = a.rows - 1; r >= 0; --r)
+        topFrom[r] = std::max(r + 1 < a.rows ? topFrom[r + 1] : rowMaxY[r], rowMaxY[r]);
+    live = n;
+    liveChunks = (n + kBrickLanes - 1) / kBrickLanes;
+}
+
+void BrickStore::kill(size_t i) {
+    if (!isAlive(i)) return;
+    size_t chunk = i / kBrickLanes;
+    laneMask[chunk] &= (uint16_t)~(1u << (i % kBrickLanes));
+    hitPoints[i] = 0;
+    live--;
+    int r = row[i];
+    if (--rowLive[r] == 0) rowBits[r / 64] &= ~(1ull << (r % 64));
+    // Each chunk is stepped over at most once per level, so this stays O(1) amortised.
+    while (liveChunks > 0 && laneMask[liveChunks - 1] == 0) liveChunks--;
+}
+
+void BrickStore::growRows(int rows) {
+    const float inf = std::numeric_limits<float>::max();
+    float bottom = bottomUpTo.empty() ? inf : bottomUpTo.back();
+    rowLive.resize(rows, 0);
+    rowBits.resize((rows + 63) / 64, 0);
+    rowMinY.resize(rows, inf);
+    rowMaxY.resize(rows, -inf);
+    bottomUpTo.resize(rows, bottom);
+    topFrom.resize(rows, -inf);
+}
+
+// Both envelopes stop at the first row they already cover, so building a
+// level row by row stays linear.
+void BrickStore::extendRow(int r, float lo, float hi) {
+    rowMinY[r] = std::min(rowMinY[r], lo);
+    rowMaxY[r] = std::max(rowMaxY[r], hi);
+    for (size_t k = r; k < bottomUpTo.size() && bottomUpTo[k] > lo; ++k) bottomUpTo[k] = lo;
+    for (int k = r; k >= 0 && topFrom[k] < hi; --k) topFrom[k] = hi;
+}
+
+bool BrickStore::liveRowsOverlap(float loY, float hiY) const {
+    // Rows before `first` lie wholly above hiY, rows from `last` on wholly below loY.
+    size_t first = std::partition_point(bottomUpTo.begin(), bottomUpTo.end(), [&](float y) { return y > hiY; }) -
+        bottomUpTo.begin();
+    size_t last = std::partition_point(topFrom.begin(), topFrom.end(), [&](float y) { return y >= loY; }) -
+        topFrom.begin();
+    while (first < last) {
+        size_t word = first / 64;
+        size_t stop = std::min(last, word * 64 + 64);
+        uint64_t bits = rowBits[word] >> (first % 64);
+        size_t width = stop - first;
+        if (width < 64) bits &= (1ull << width) - 1;
+        if (bits) return true;
+        first = stop;
+    }
+    return false;
+}
+
+bool BrickStore::hit(size_t i) {
+    if (!isAlive(i)) return false;
+    if (hitPoints[i] > 1) {
+        hitPoints[i]--;
+        return false;
+    }
+    kill(i);
+    return true;
+}
+
+size_t circleOverlapScalar(const BrickStore& bricks, size_t begin, size_t end,
+    const glm::vec2& c, float r, uint32_t* out)
+{
+    size_t hits = 0;
+    glm::vec2 closest;
+    for (size_t i = begin; i < end; ++i) {
+        if (!bricks.isAlive(i)) continue;
+        if (AABBvsCircle(bricks.pos(i), bricks.extent(i), c, r, closest))
+            out[hits++] = (uint32_t)i;
+    }
+    return hits;
+}
+
+#ifdef ARK_X86
+
+namespace {
+
+inline unsigned lowestBit(uint32_t v) {
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward(&i, v);
+    return (unsigned)i;
+#else
+    return (unsigned)__builtin_ctz(v);
+#endif
+}
+
+inline size_t emitBits(uint32_t bits, size_t base, size_t end, uint32_t* out, size_t hits) {
+    while (bits) {
+        unsigned lane = lowestBit(bits);
+        bits &= bits - 1;
+        if (base + lane < end) out[hits++] = (uint32_t)(base + lane);
+    }
+    return hits;
+}
+
+size_t circleOverlapSse(const BrickStore& b, size_t begin, size_t end,
+    const glm::vec2& c, float r, uint32_t* out)
+{
+    const __m128 cx = _mm_set1_ps(c.x), cy = _mm_set1_ps(c.y), r2 = _mm_set1_ps(r * r);
+    size_t hits = 0;
+    end = std::min(end, b.liveEnd());
+    for (size_t i = begin; i < end; i += 16) {
+        uint32_t live = b.laneMask[i / 16];
+        if (!live) continue;
+        uint32_t bits = 0;
+        for (int k = 0; k < 16; k += 4) {
+            __m128 dx = _mm_sub_ps(_mm_max_ps(_mm_loadu_ps(&b.minX[i + k]), _mm_min_ps(cx, _mm_loadu_ps(&b.maxX[i + k]))), cx);
+            __m128 dy = _mm_sub_ps(_mm_max_ps(_mm_loadu_ps(&b.minY[i + k]), _mm_min_ps(cy, _mm_loadu_ps(&b.maxY[i + k]))), cy);
+            __m128 d2 = _mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy));
+            bits |= (uint32_t)_mm_movemask_ps(_mm_cmple_ps(d2, r2)) << k;
+        }
+        hits = emitBits(bits & live, i, end, out, hits);
+    }
+    return hits;
+}
+
+ARK_TARGET("avx2")
+size_t circleOverlapAvx2(const BrickStore& b, size_t begin, size_t end,
+    const glm::vec2& c, float r, uint32_t* out)
+{
+    const __m256 cx = _mm256_set1_ps(c.x), cy = _mm256_set1_ps(c.y), r2 = _mm256_set1_ps(r * r);
+    size_t hits = 0;
+    end = std::min(end, b.liveEnd());
+    for (size_t i = begin; i < end; i += 16) {
+        uint32_t live = b.laneMask[i / 16];
+        if (!live) continue;
+        uint32_t bits = 0;
+        for (int k = 0; k < 16; k += 8) {
+            __m256 dx = _mm256_sub_ps(_mm256_max_ps(_mm256_loadu_ps(&b.minX[i + k]), _mm256_min_ps(cx, _mm256_loadu_ps(&b.maxX[i + k]))), cx);
+            __m256 dy = _mm256_sub_ps(_mm256_max_ps(_mm256_loadu_ps(&b.minY[i + k]), _mm256_min_ps(cy, _mm256_loadu_ps(&b.maxY[i + k]))), cy);
+            __m256 d2 = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+            bits |= (uint32_t)_mm256_movemask_ps(_mm256_cmp_ps(d2, r2, _CMP_LE_OQ)) << k;
+        }
+        hits = emitBits(bits & live, i, end, out, hits);
+    }
+    return hits;
+}
+
+ARK_TARGET("avx512f")
+size_t circleOverlapAvx512(const BrickStore& b, size_t begin, size_t end,
+    const glm::vec2& c, float r, uint32_t* out)
+{
+    const __m512 cx = _mm512_set1_ps(c.x), cy = _mm512_set1_ps(c.y), r2 = _mm512_set1_ps(r * r);
+    size_t hits = 0;
+    end = std::min(end, b.liveEnd());
+    for (size_t i = begin; i < end; i += 16) {
+        uint32_t live = b.laneMask[i / 16];
+        if (!live) continue;
+        __m512 dx = _mm512_sub_ps(_mm512_max_ps(_mm512_loadu_ps(&b.minX[i]), _mm512_min_ps(cx, _mm512_loadu_ps(&b.maxX[i]))), cx);
+        __m512 dy = _mm512_sub_ps(_mm512_max_ps(_mm512_loadu_ps(&b.minY[i]), _mm512_min_ps(cy, _mm512_loadu_ps(&b.maxY[i]))), cy);
+        __m512 d2 = _mm512_add_ps(_mm512_mul_ps(dx, dx), _mm512_mul_ps(dy, dy));
+        uint32_t bits = (uint32_t)_mm512_cmp_ps_mask(d2, r2, _CMP_LE_OQ);
+        hits = emitBits(bits & live, i, end, out, hits);
+    }
+    return hits;
+}
+
+void cpuid(int leaf, int sub, unsigned regs[4]) {
+#if defined(_MSC_VER)
+    int r[4];
+    __cpuidex(r, leaf, sub);
+    for (int i = 0; i < 4; ++i) regs[i] = (unsigned)r[i];
+#else
+    __cpuid_count(leaf, sub, regs[0], regs[1], regs[2], regs[3]);
+#endif
+}
+
+unsigned long long xgetbv0() {
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned lo, hi;
+    __asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+    return ((unsigned long long)hi << 32) | lo;
+#endif
+}
+
+typedef size_t (*CircleOverlapFn)(const BrickStore&, size_t, size_t, const glm::vec2&, float, uint32_t*);
+
+struct CircleKernel {
+    CircleOverlapFn fn;
+    const char* isa;
+};
+
+// AVX state must be enabled by the OS (XCR0), not just reported by CPUID.
+CircleKernel pickKernel() {
+    unsigned regs[4];
+    cpuid(0, 0, regs);
+    unsigned maxLeaf = regs[0];
+    cpuid(1, 0, regs);
+    bool osxsave = (regs[2] & (1u << 27)) != 0;
+    bool avx = (regs[2] & (1u << 28)) != 0;
+    if (!osxsave || !avx || maxLeaf < 7) return { circleOverlapSse, "sse" };
+
+    unsigned long long xcr0 = xgetbv0();
+    cpuid(7, 0, regs);
+    bool avx2 = (regs[1] & (1u << 5)) != 0 && (xcr0 & 0x6) == 0x6;
+    bool avx512 = (regs[1] & (1u << 16)) != 0 && (xcr0 & 0xE6) == 0xE6;
+    if (avx512) return { circleOverlapAvx512, "avx512" };
+    if (avx2) return { circleOverlapAvx2, "avx2" };
+    return { circleOverlapSse, "sse" };
+}
+
+const CircleKernel& kernel() {
+    static const CircleKernel k = pickKernel();
+    return k;
+}
+
+}
+
+size_t circleOverlapBatch(const BrickStore& bricks, size_t begin, size_t end,
+    const glm::vec2& c, float r, uint32_t* out)
+{
+    return kernel().fn(bricks, begin, end, c, r, out);
+}
+
+const char* circleOverlapIsa() {
+    return kernel().isa;
+}
+
+#else
+
+size_t circleOverlapBatch(const BrickStore& bricks, size_t begin, size_t end,
+    const glm::vec2& c, float r, uint32_t* out)
+{
+    return circleOverlapScalar(bricks, begin, end, c, r, out);
+}
+
+const char* circleOverlapIsa() {
+    return "scalar";
+}
+
+#endif
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Read-only per-brick arrays, each padded to a multiple of kBrickLanes. A
+// compiled level file holds exactly this layout, so a mapped level is used
+// in place.
+struct BrickArrays {
+    size_t count = 0, padded = 0;
+    int rows = 0;
+    const float *minX = nullptr, *minY = nullptr, *maxX = nullptr, *maxY = nullptr;
+    const glm::vec4* color = nullptr;
+    const int32_t* row = nullptr;
+    const uint8_t* hitPoints = nullptr;
+    const uint8_t* drop = nullptr;
+    const uint32_t* rowCounts = nullptr;   // bricks per row, `rows` entries
+};
+
+// Structure-of-arrays brick storage. Collision only ever reads the bounds and
+// the occupancy masks, so they sit in their own tightly packed streams; colour
+// is kept apart for the renderer. Arrays are padded with dead entries to a
+// multiple of kBrickLanes so SIMD kernels never need a scalar tail.
+//
+// Occupancy is kept up to date by kill(): a live counter, one bit per brick
+// in a 16-bit mask per chunk of kBrickLanes bricks, and a live count and bit
+// per row. Win detection is liveCount() == 0, scans can skip empty chunks,
+// and a ball move that crosses no row with live bricks needs no brick search
+// at all.
+//
+// Bounds, colour, row and drop never change after a level is built. They
+// are views into arrays this store owns (add()) or someone else keeps alive
+// (attach()), and copies of the store share them. Only hit points and
+// occupancy are per store.
+struct BrickStore {
+    static const size_t kBrickLanes = 16;
+    // Values of drop[]: roll the level's power-up table, never drop, or
+    // kDropType + type to always drop that power-up.
+    static const uint8_t kDropRoll = 0, kDropType = 1, kDropNever = 0xFF;
+
+    const float *minX = nullptr, *minY = nullptr, *maxX = nullptr, *maxY = nullptr;
+    const glm::vec4* color = nullptr;
+    const int32_t* row = nullptr;
+    const uint8_t* drop = nullptr;
+    std::vector<uint16_t> laneMask;   // per chunk, bit i set while brick chunk * 16 + i is alive
+    std::vector<uint8_t> hitPoints;   // hits left; the brick dies when this reaches zero
+
+    void clear();
+    int add(const glm::vec2& pos, const glm::vec2& size, const glm::vec4& c, int brickRow = 0,
+        int hp = 1, uint8_t dropKind = kDropRoll);
+    // Uses the arrays in place; `owner` keeps them alive for as long as any
+    // copy of this store does.
+    void attach(const BrickArrays& arrays, std::shared_ptr<const void> owner);
+
+    size_t count() const { return n; }
+    size_t paddedCount() const { return padded; }
+    size_t liveCount() const { return live; }
+    // One past the last chunk that still holds a live brick, in bricks.
+    size_t liveEnd() const { return liveChunks * kBrickLanes; }
+
+    glm::vec2 pos(size_t i) const { return glm::vec2(minX[i], minY[i]); }
+    glm::vec2 extent(size_t i) const { return glm::vec2(maxX[i] - minX[i], maxY[i] - minY[i]); }
+    bool isAlive(size_t i) const { return (laneMask[i / kBrickLanes] >> (i % kBrickLanes)) & 1u; }
+    void kill(size_t i);
+    // Takes one hit point off a live brick and kills it at zero; true if it died.
+    bool hit(size_t i);
+
+    // True if a row that still has live bricks reaches into [loY, hiY]. Rows
+    // are numbered top down, so the rows a y range can touch are a run of
+    // row bits: two binary searches and a test of those bits. If a level's
+    // rows overlap or come out of order the run is wider and the answer may
+    // be a false true, never a false false.
+    bool liveRowsOverlap(float loY, float hiY) const;
+
+private:
+    struct Owned {
+        std::vector<float> minX, minY, maxX, maxY;
+        std::vector<glm::vec4> color;
+        std::vector<int32_t> row;
+        std::vector<uint8_t> drop;
+    };
+
+    void makeOwned();
+    void bindOwned();
+
+    std::shared_ptr<Owned> owned;
+    std::shared_ptr<const void> backing;
+    size_t padded = 0;
+    size_t n = 0;
+    size_t live = 0;
+    size_t liveChunks = 0;
+    void growRows(int rows);
+    void extendRow(int r, float lo, float hi);
+
+    std::vector<int> rowLive;
+    std::vector<uint64_t> rowBits;   // bit r set while row r has live bricks
+    std::vector<float> rowMinY, rowMaxY;   // vertical extent of each row's bricks
+    // Lowest bottom among rows 0..r and highest top among rows r.. on; both
+    // only ever fall with r, so they can be binary searched.
+    std::vector<float> bottomUpTo, topFrom;
+};
+
+// Writes the indices of live bricks in [begin, end) that overlap the circle,
+// in ascending order, and returns how many were written. `begin` must be a
+// multiple of kBrickLanes; `out` needs room for end - begin entries.
+size_t circleOverlapBatch(const BrickStore& bricks, size_t begin, size_t end,
+    const glm::vec2& c, float r, uint32_t* out);
+
+// Same contract, always the plain scalar loop; kept for reference and benchmarks.
+size_t circleOverlapScalar(const BrickStore& bricks, size_t begin, size_t end,
+    const glm::vec2& c, float r, uint32_t* out);
+
+// Name of the instruction set circleOverlapBatch picked on this CPU.
+const char* circleOverlapIsa();
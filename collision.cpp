@@ -0,0 +1,100 @@
+#include "collision.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool AABBvsCircle(const glm::vec2& aPos, const glm::vec2& aSize,
+    const glm::vec2& cPos, float r, glm::vec2& outClosest)
+{
+    glm::vec2 aMin = aPos;
+    glm::vec2 aMax = aPos + aSize;
+    float cx = std::max(aMin.x, std::min(cPos.x, aMax.x));
+    float cy = std::max(aMin.y, std::min(cPos.y, aMax.y));
+    outClosest = glm::vec2(cx, cy);
+    float dx = cx - cPos.x;
+    float dy = cy - cPos.y;
+    return (dx * dx + dy * dy) <= r * r;
+}
+
+namespace {
+
+// Smallest t in [0, 1] with |p + t*d - c| == r, for a circle that starts outside.
+bool sweepCirclePoint(const glm::vec2& p, const glm::vec2& d, float r, const glm::vec2& c, float& outT) {
+    glm::vec2 m = p - c;
+    float a = glm::dot(d, d);
+    float b = glm::dot(m, d);
+    float k = glm::dot(m, m) - r * r;
+    if (a <= 0.0f || b >= 0.0f) return false;
+    float disc = b * b - a * k;
+    if (disc < 0.0f) return false;
+    float t = (-b - std::sqrt(disc)) / a;
+    if (t < 0.0f || t > 1.0f) return false;
+    outT = t;
+    return true;
+}
+
+}
+
+bool sweepCircleAABB(const glm::vec2& p, const glm::vec2& d, float r,
+    const glm::vec2& bMin, const glm::vec2& bMax, float& outT, glm::vec2& outNormal)
+{
+    glm::vec2 closest;
+    if (AABBvsCircle(bMin, bMax - bMin, p, r, closest)) {
+        glm::vec2 n = p - closest;
+        float len = glm::length(n);
+        if (len > 1e-6f) {
+            n /= len;
+        }
+        else {
+            // Centre is inside the box: push out through the nearest face.
+            float dl = p.x - bMin.x, dr = bMax.x - p.x, db = p.y - bMin.y, dt = bMax.y - p.y;
+            float m = std::min(std::min(dl, dr), std::min(db, dt));
+            n = (m == dl) ? glm::vec2(-1, 0) : (m == dr) ? glm::vec2(1, 0) : (m == db) ? glm::vec2(0, -1) : glm::vec2(0, 1);
+        }
+        if (glm::dot(d, n) >= 0.0f) return false;
+        outT = 0.0f;
+        outNormal = n;
+        return true;
+    }
+
+    // Slab test of the centre's ray against the box grown by r on every side.
+    glm::vec2 eMin = bMin - glm::vec2(r), eMax = bMax + glm::vec2(r);
+    float tEnter = 0.0f, tExit = 1.0f;
+    glm::vec2 n(0.0f);
+    for (int axis = 0; axis < 2; ++axis) {
+        if (std::fabs(d[axis]) < 1e-12f) {
+            if (p[axis] < eMin[axis] || p[axis] > eMax[axis]) return false;
+            continue;
+        }
+        float inv = 1.0f / d[axis];
+        float t0 = (eMin[axis] - p[axis]) * inv;
+        float t1 = (eMax[axis] - p[axis]) * inv;
+        float sign = -1.0f;
+        if (t0 > t1) { std::swap(t0, t1); sign = 1.0f; }
+        if (t0 > tEnter) {
+            tEnter = t0;
+            n = glm::vec2(0.0f);
+            n[axis] = sign;
+        }
+        tExit = std::min(tExit, t1);
+        if (tEnter > tExit) return false;
+    }
+
+    // The grown box has square corners where the real swept shape is rounded;
+    // entering through a corner region needs the exact circle-vs-vertex time.
+    glm::vec2 q = p + d * tEnter;
+    bool outX = q.x < bMin.x || q.x > bMax.x;
+    bool outY = q.y < bMin.y || q.y > bMax.y;
+    if (outX && outY) {
+        glm::vec2 corner(q.x < bMin.x ? bMin.x : bMax.x, q.y < bMin.y ? bMin.y : bMax.y);
+        float t;
+        if (!sweepCirclePoint(p, d, r, corner, t)) return false;
+        outT = t;
+        outNormal = (p + d * t - corner) / r;
+        return true;
+    }
+
+    outT = tEnter;
+    outNormal = n;
+    return true;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <glm.hpp>
+
+bool AABBvsCircle(const glm::vec2& aPos, const glm::vec2& aSize,
+    const glm::vec2& cPos, float r, glm::vec2& outClosest);
+
+// Continuous test of a circle of radius r moving from p by d against the box
+// [bMin, bMax]. On contact within the move, outT is the fraction of d at first
+// touch and outNormal points from the box towards the circle. A circle that
+// already overlaps the box reports t = 0, but only while it is moving inwards.
+bool sweepCircleAABB(const glm::vec2& p, const glm::vec2& d, float r,
+    const glm::vec2& bMin, const glm::vec2& bMax, float& outT, glm::vec2& outNormal);
@@ -10,13 +10,33 @@
 #include <string>
 #include <fstream>
 #include <sstream>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
 #include <cstdlib>
 #include <ctime>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
+#include "alloc_stats.h"
+#include "asset_loader.h"
+#include "bench.h"
+#include "collision.h"
+#include "fixed_step.h"
+#include "font.h"
+#include "frame_renderer.h"
+#include "game_world.h"
+#include "gpu_timer.h"
+#include "level.h"
+#include "particles.h"
+#include "profiler.h"
+#include "render_device.h"
+#include "render_queue.h"
+#include "replay.h"
+#include "sprite_batch.h"
+#include "texture_atlas.h"
+
 GLuint compileShader(GLenum type, const char* src) {
     GLuint s = glCreateShader(type);
     glShaderSource(s, 1, &src, nullptr);
@@ -47,25 +67,29 @@ const char* quad_vs = R"(
 #version 330 core
 layout(location=0) in vec2 inPos;
 layout(location=1) in vec2 inUV;
+layout(location=2) in vec4 instRect;
+layout(location=3) in vec4 instColor;
+layout(location=4) in vec4 instUV;
 
 uniform mat4 projection;
-uniform mat4 model;
 
 out vec2 uv;
+out vec4 color;
 
 void main(){
-    uv = inUV;
-    gl_Position = projection * model * vec4(inPos, 0.0, 1.0);
+    uv = mix(instUV.xy, instUV.zw, inUV);
+    color = instColor;
+    gl_Position = projection * vec4(instRect.xy + inPos * instRect.zw, 0.0, 1.0);
 }
 )";
 
 const char* quad_fs = R"(
 #version 330 core
 in vec2 uv;
+in vec4 color;
 out vec4 FragColor;
 
 uniform sampler2D tex;
-uniform vec4 color;
 
 void main(){
     vec4 t = texture(tex, uv);
@@ -76,52 +100,29 @@ void main(){
 const char* rect_vs = R"(
 #version 330 core
 layout(location=0) in vec2 inPos;
+layout(location=1) in vec4 instRect;
+layout(location=2) in vec4 instColor;
 
 uniform mat4 projection;
-uniform mat4 model;
+
+out vec4 color;
 
 void main(){
-    gl_Position = projection * model * vec4(inPos, 0.0, 1.0);
+    color = instColor;
+    gl_Position = projection * vec4(instRect.xy + inPos * instRect.zw, 0.0, 1.0);
 }
 )";
 
 const char* rect_fs = R"(
 #version 330 core
+in vec4 color;
 out vec4 FragColor;
 
-uniform vec4 color;
-
 void main(){
     FragColor = color;
 }
 )";
 
-GLuint loadTexture(const char* path) {
-    int w, h, channels;
-    stbi_set_flip_vertically_on_load(true);
-    unsigned char* data = stbi_load(path, &w, &h, &channels, 4);
-    if (!data) {
-        std::cout << "Failed to load texture: " << path << std::endl;
-        return 0;
-    }
-
-    GLuint tex;
-    glGenTextures(1, &tex);
-    glBindTexture(GL_TEXTURE_2D, tex);
-
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
-
-    glGenerateMipmap(GL_TEXTURE_2D);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-
-    stbi_image_free(data);
-    return tex;
-}
-
-
 GLuint createQuadVAO() {
     float data[] = {
         0.0f, 1.0f,  0.0f, 1.0f,
@@ -167,251 +168,76 @@ GLuint createRectVAO() {
     return VAO;
 }
 
-struct Sprite {
-    glm::vec2 pos;
-    glm::vec2 size;
-    float rotation = 0.0f;
-    GLuint tex = 0;
-    glm::vec4 color = glm::vec4(1.0f);
-    bool transparent = false;
-    float depth = 0.0f;
-};
-
-struct Brick {
-    Sprite s;
-    bool alive = true;
-};
-
-struct Ball {
-    glm::vec2 pos;
-    glm::vec2 vel;
-    float radius;
-    GLuint tex;
-};
-
-struct Paddle {
-    glm::vec2 pos;
-    glm::vec2 size;
-    GLuint tex;
-};
-
-enum PowerUpType {
-    MULTIBALL = 0,
-    EXTRALIFE = 1
-};
-
-struct PowerUp {
-    glm::vec2 pos;
-    glm::vec2 vel;
-    glm::vec2 size;
-    PowerUpType type;
-    bool active;
-    GLuint tex;
-};
-
-bool AABBvsCircle(const glm::vec2& aPos, const glm::vec2& aSize,
-    const glm::vec2& cPos, float r, glm::vec2& outClosest)
-{
-    glm::vec2 aMin = aPos;
-    glm::vec2 aMax = aPos + aSize;
-    float cx = std::max(aMin.x, std::min(cPos.x, aMax.x));
-    float cy = std::max(aMin.y, std::min(cPos.y, aMax.y));
-    outClosest = glm::vec2(cx, cy);
-    float dx = cx - cPos.x;
-    float dy = cy - cPos.y;
-    return (dx * dx + dy * dy) <= r * r;
-}
-
-void drawRect(float x, float y, float w, float h, glm::vec4 color,
-    GLuint program, GLuint VAO, const glm::mat4& proj) {
-    GLint loc_projection = glGetUniformLocation(program, "projection");
-    GLint loc_model = glGetUniformLocation(program, "model");
-    GLint loc_color = glGetUniformLocation(program, "color");
-
-    glUseProgram(program);
-    glUniformMatrix4fv(loc_projection, 1, GL_FALSE, &proj[0][0]);
-    glUniform4fv(loc_color, 1, &color[0]);
-
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, glm::vec3(x, y, 0.0f));
-    model = glm::scale(model, glm::vec3(w, h, 1.0f));
+int WINDOW_W = 800, WINDOW_H = 600;
 
-    glUniformMatrix4fv(loc_model, 1, GL_FALSE, &model[0][0]);
-    glBindVertexArray(VAO);
-    glDrawArrays(GL_TRIANGLES, 0, 6);
+enum { IMG_BRICK, IMG_PADDLE, IMG_BALL, IMG_HEART };
+const std::vector<std::string> kSpritePaths = { "brick.png", "paddle.png", "ball.png", "heart.png" };
+// Main-thread time per frame for turning decoded assets into textures.
+const double kAssetUploadBudgetMs = 2.0;
+
+SpriteSkin skinFromAtlas(const TextureAtlas& atlas) {
+    SpriteSkin skin;
+    skin.tex = atlas.tex;
+    skin.brick = atlas.regions[IMG_BRICK].uv;
+    skin.paddle = atlas.regions[IMG_PADDLE].uv;
+    skin.ball = atlas.regions[IMG_BALL].uv;
+    skin.heart = atlas.regions[IMG_HEART].uv;
+    return skin;
 }
 
-void drawBigText(const std::string& text, float x, float y, float scale, glm::vec4 color,
-    GLuint program, GLuint VAO, const glm::mat4& proj) {
-
-    float charW = 45.0f * scale;
-    float charH = 70.0f * scale;
-    float thick = 8.0f * scale;
-    float gap = 15.0f * scale;
-
-    float currentX = x;
-
-    for (char c : text) {
-        if (c == ' ') {
-            currentX += charW * 0.8f;
-            continue;
-        }
-
-        switch (c) {
-        case 'G':
-            drawRect(currentX, y, thick, charH, color, program, VAO, proj);
-            drawRect(currentX, y + charH - thick, charW, thick, color, program, VAO, proj);
-            drawRect(currentX, y, charW, thick, color, program, VAO, proj);
-            drawRect(currentX + charW - thick, y, thick, charH * 0.5f, color, program, VAO, proj);
-            drawRect(currentX + charW * 0.4f, y + charH * 0.4f, charW * 0.6f - thick, thick, color, program, VAO, proj);
-            break;
-        case 'A':
-            drawRect(currentX, y, thick, charH, color, program, VAO, proj);
-            drawRect(currentX + charW - thick, y, thick, charH, color, program, VAO, proj);
-            drawRect(currentX, y + charH - thick, charW, thick, color, program, VAO, proj);
-            drawRect(currentX, y + charH * 0.4f, charW, thick, color, program, VAO, proj);
-            break;
-        case 'M': {
-            drawRect(currentX, y, thick, charH, color, program, VAO, proj);
-            drawRect(currentX + charW - thick, y, thick, charH, color, program, VAO, proj);
-
-            for (float i = 0; i < charH / 2.0f; i += thick) {
-                float dx = i * (charW / (charH)); 
-                float dy = i;                      
-                drawRect(currentX + dx, y + charH - i - thick, thick, thick, color, program, VAO, proj);
-            }
-
-            for (float i = 0; i < charH / 2.0f; i += thick) {
-                float dx = i * (charW / (charH));
-                drawRect(currentX + charW - dx - thick, y + charH - i - thick, thick, thick, color, program, VAO, proj);
-            }
-            break;
-        }
-
-
-        case 'E':
-            drawRect(currentX, y, thick, charH, color, program, VAO, proj);
-            drawRect(currentX, y + charH - thick, charW, thick, color, program, VAO, proj);
-            drawRect(currentX, y + charH * 0.45f, charW * 0.8f, thick, color, program, VAO, proj);
-            drawRect(currentX, y, charW, thick, color, program, VAO, proj);
-            break;
-        case 'O':
-            drawRect(currentX, y, thick, charH, color, program, VAO, proj);
-            drawRect(currentX + charW - thick, y, thick, charH, color, program, VAO, proj);
-            drawRect(currentX, y + charH - thick, charW, thick, color, program, VAO, proj);
-            drawRect(currentX, y, charW, thick, color, program, VAO, proj);
-            break;
-        case 'V': {
-            for (float i = 0; i < charH; i += thick) {
-                float dx = (i / charH) * (charW * 0.5f); 
-                drawRect(currentX + dx, y + charH - i - thick, thick, thick, color, program, VAO, proj);
-            }
-
-            for (float i = 0; i < charH; i += thick) {
-                float dx = (i / charH) * (charW * 0.5f); 
-                drawRect(currentX + charW - dx - thick, y + charH - i - thick, thick, thick, color, program, VAO, proj);
-            }
-            break;
-        }
-
-                break;
-        case 'R': {
-            drawRect(currentX, y, thick, charH, color, program, VAO, proj);
-            drawRect(currentX, y + charH - thick, charW * 0.7f, thick, color, program, VAO, proj);
-
-            drawRect(currentX, y + charH * 0.55f, charW * 0.7f, thick, color, program, VAO, proj);
-
-            drawRect(currentX + charW * 0.7f - thick, y + charH * 0.55f, thick, charH * 0.45f - thick, color, program, VAO, proj);
-
-            for (float i = 0; i < charH * 0.45f; i += thick) {
-                float dx = (i / (charH * 0.45f)) * (charW * 0.4f); 
-                drawRect(currentX + charW * 0.7f - dx - thick, y + i, thick, thick, color, program, VAO, proj);
-            }
-            break;
-        }
-
-
-
-
-        case 'Y': {
-            float midX = currentX + charW * 0.5f;
-            float halfW = charW * 0.5f;
-
-            drawRect(currentX, y + charH * 0.5f, thick, charH * 0.5f, color, program, VAO, proj);
-            glPushMatrix();
-            glTranslatef(currentX + halfW * 0.25f, y + charH * 0.75f, 0);
-            glRotatef(45, 0, 0, 1);
-            glPopMatrix();
+// Frames a trace started with --trace or F4 covers.
+const int kTraceFrames = 300;
 
-            drawRect(currentX + charW - thick, y + charH * 0.5f, thick, charH * 0.5f, color, program, VAO, proj);
-
-            drawRect(midX - thick * 0.5f, y, thick, charH * 0.5f, color, program, VAO, proj);
-            break;
-        }
-
-        case 'U':
-            drawRect(currentX, y + thick, thick, charH - thick, color, program, VAO, proj);
-            drawRect(currentX + charW - thick, y + thick, thick, charH - thick, color, program, VAO, proj);
-            drawRect(currentX, y, charW, thick, color, program, VAO, proj);
-            break;
-        case 'W':
-            drawRect(currentX, y, thick, charH, color, program, VAO, proj);
-            drawRect(currentX + charW - thick, y, thick, charH, color, program, VAO, proj);
-            drawRect(currentX, y, charW, thick, color, program, VAO, proj);
-            drawRect(currentX + charW * 0.5f - thick * 0.5f, y + thick, thick, charH * 0.5f, color, program, VAO, proj);
-            break;
-        case 'I':
-            drawRect(currentX + charW * 0.4f, y, thick, charH, color, program, VAO, proj);
-            drawRect(currentX, y, charW, thick, color, program, VAO, proj);
-            drawRect(currentX, y + charH - thick, charW, thick, color, program, VAO, proj);
-            break;
-        case 'N': {
-            drawRect(currentX, y, thick, charH, color, program, VAO, proj);
-
-            drawRect(currentX + charW - thick, y, thick, charH, color, program, VAO, proj);
-
-            int segments = 10; 
-            for (int i = 0; i < segments; i++) {
-                float t = (float)i / segments;
-                float segX = currentX + (1.0f - t) * (charW - thick);
-                float segY = y + t * (charH - thick);
-                drawRect(segX, segY, thick, thick, color, program, VAO, proj);
-            }
-            break;
-        }
-
-        case '!':
-            drawRect(currentX + charW * 0.4f, y + charH * 0.3f, thick, charH * 0.7f, color, program, VAO, proj);
-            drawRect(currentX + charW * 0.4f, y, thick, thick * 1.5f, color, program, VAO, proj);
-            break;
-        }
-
-        currentX += charW + gap;
-    }
-}
-
-int WINDOW_W = 800, WINDOW_H = 600;
 bool keys[1024];
 
-glm::vec2 getTextSize(const std::string& text, float scale) {
-    float charW = 50.0f * scale;
-    float gap = 15.0f * scale;
-    int count = 0;
-    for (char c : text)
-        if (c != ' ') count++;
-    float totalWidth = count * charW + (count - 1) * gap;
-    float totalHeight = 70.0f * scale;
-    return glm::vec2(totalWidth, totalHeight);
-}
-
-
 void key_callback(GLFWwindow* w, int key, int sc, int action, int mods) {
     if (action == GLFW_PRESS) keys[key] = true;
     else if (action == GLFW_RELEASE) keys[key] = false;
 }
 
-int main() {
-    srand((unsigned int)time(nullptr));
+int main(int argc, char** argv) {
+    auto startTime = std::chrono::steady_clock::now();
+    if (argc > 2 && std::string(argv[1]) == "--bench")
+        return runBenchmark(argv[2]);
+    if (argc > 2 && std::string(argv[1]) == "--replay")
+        return runReplay(argv[2]);
+    if (argc > 3 && std::string(argv[1]) == "--compile-level")
+        return runLevelCompiler(argv[2], argv[3]);
+
+    double simHz = 240.0;
+    int maxCatchUp = 8;
+    bool stressMode = false;
+    uint32_t seed = (uint32_t)time(nullptr);
+    std::string recordPath;
+    std::string levelPath;
+    bool syncAssets = false;
+    std::string tracePath = "trace.json";
+    bool traceAtStart = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--hz" && i + 1 < argc) simHz = std::max(1.0, atof(argv[++i]));
+        else if (arg == "--max-catchup" && i + 1 < argc) maxCatchUp = std::max(1, atoi(argv[++i]));
+        else if (arg == "--stress") stressMode = true;
+        else if (arg == "--seed" && i + 1 < argc) seed = (uint32_t)strtoul(argv[++i], nullptr, 10);
+        else if (arg == "--record" && i + 1 < argc) recordPath = argv[++i];
+        else if (arg == "--level" && i + 1 < argc) levelPath = argv[++i];
+        else if (arg == "--sync-assets") syncAssets = true;
+        else if (arg == "--trace" && i + 1 < argc) { tracePath = argv[++i]; traceAtStart = true; }
+    }
+
+    profiler.enable(true);
+    profiler.setThreadName("main");
+    if (traceAtStart) profiler.startTrace(tracePath, kTraceFrames);
+
+    std::shared_ptr<const Level> level;
+    if (!levelPath.empty()) {
+        std::string error;
+        level = loadLevel(levelPath, error);
+        if (!level) { std::cerr << levelPath << ": " << error << "\n"; return -1; }
+        if (level->header().width != WINDOW_W || level->header().height != WINDOW_H)
+            std::cerr << levelPath << ": laid out for " << level->header().width << "x" << level->header().height
+                << ", playing it in " << WINDOW_W << "x" << WINDOW_H << "\n";
+    }
 
     if (!glfwInit()) { std::cerr << "GLFW init failed\n"; return -1; }
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -426,302 +252,222 @@ int main() {
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) { std::cerr << "GLAD failed\n"; return -1; }
     glViewport(0, 0, WINDOW_W, WINDOW_H);
 
-    glEnable(GL_BLEND);
-    glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-
     GLuint program = linkProgram(quad_vs, quad_fs);
     GLuint rectProgram = linkProgram(rect_vs, rect_fs);
     GLuint VAO = createQuadVAO();
     GLuint rectVAO = createRectVAO();
 
+    GpuTimer gpuTimer;
+    std::cout << "GPU pass timing " << (gpuTimer.init() ? "on" : "unavailable") << "\n";
+
     glm::mat4 proj = glm::ortho(0.0f, (float)WINDOW_W, 0.0f, (float)WINDOW_H, -1.0f, 1.0f);
-    GLint loc_projection = glGetUniformLocation(program, "projection");
-    GLint loc_model = glGetUniformLocation(program, "model");
-    GLint loc_color = glGetUniformLocation(program, "color");
-    GLint loc_tex = glGetUniformLocation(program, "tex");
-
-    GLuint tex_brick = loadTexture("brick.png");
-    GLuint tex_paddle = loadTexture("paddle.png");
-    GLuint tex_ball = loadTexture("ball.png");
-    GLuint tex_heart = loadTexture("heart.png");
-
-
-    auto makeFallback = []() {
-        GLuint t; glGenTextures(1, &t); glBindTexture(GL_TEXTURE_2D, t);
-        unsigned char white[4] = { 255,255,255,255 };
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        return t;
-        };
-    if (!tex_brick) tex_brick = makeFallback();
-    if (!tex_paddle) tex_paddle = makeFallback();
-    if (!tex_ball) tex_ball = makeFallback();
-    if (!tex_heart) tex_heart = makeFallback();
-
-    Paddle paddle;
-    paddle.size = glm::vec2(120.0f, 20.0f);
-    paddle.pos = glm::vec2(WINDOW_W / 2.0f - paddle.size.x / 2.0f, 50.0f);
-    paddle.tex = tex_paddle;
-
-    std::vector<Ball> balls;
-    Ball ball;
-    ball.radius = 10.0f;
-    ball.pos = glm::vec2(WINDOW_W / 2.0f, 200.0f);
-    ball.vel = glm::vec2(200.0f, 200.0f);
-    ball.tex = tex_ball;
-    balls.push_back(ball);
-
-    std::vector<PowerUp> powerUps;
-    int lives = 5;
-    bool gameOver = false;
-    bool youWin = false;
-
-    std::vector<Brick> bricks;
-    int rows = 5, cols = 10;
-    float margin = 10.0f;
-    float brickW = (WINDOW_W - (cols + 1) * margin) / cols;
-    float brickH = 30.0f;
-    for (int r = 0; r < rows; ++r) {
-        for (int c = 0; c < cols; ++c) {
-            Brick b;
-            b.alive = true;
-            b.s.pos = glm::vec2(margin + c * (brickW + margin), WINDOW_H - (r + 1) * (brickH + 20.0f));
-            b.s.size = glm::vec2(brickW, brickH);
-            b.s.tex = tex_brick;
-            b.s.color = glm::vec4(1.0f - r * 0.12f, 0.2f + r * 0.12f, 0.3f + c * 0.01f, 1.0f);
-            b.s.transparent = false;
-            bricks.push_back(b);
-        }
+
+    // Redundant binds and uniform uploads stop at the cache. Anything that
+    // calls GL directly in between (texture uploads) invalidates it.
+    GlRenderDevice glDevice;
+    CachingRenderDevice device(glDevice);
+    device.setBlend(true);
+    device.blendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    FrameRenderer renderer;
+    renderer.init(device, program, rectProgram, VAO, createQuadVAO(), createQuadVAO(), rectVAO,
+        (int)ParticleConfig().capacity);
+
+    // Asynchronously, the game starts on a plain white placeholder (sprites
+    // draw as tinted quads, text is empty) and switches over as each texture
+    // lands. --sync-assets loads everything up front instead.
+    SpriteSkin skin;
+    Font font;
+    AssetLoader assets;
+    bool skinChanged = false;
+    if (syncAssets) {
+        skin = skinFromAtlas(bakeAtlas(kSpritePaths));
+        font.load("arial.ttf", 48.0f);
     }
+    else {
+        skin.tex = makePlaceholderTexture();
+        assets.submit([&](TextureUpload& upload) {
+            auto atlas = std::make_shared<TextureAtlas>();
+            buildAtlas(kSpritePaths, *atlas, upload.rgba);
+            upload.width = atlas->width;
+            upload.height = atlas->height;
+            upload.maxLevel = atlas->maxLevel;
+            upload.onReady = [&, atlas](GLuint tex) {
+                atlas->tex = tex;
+                describeAtlas(*atlas, kSpritePaths.size());
+                skin = skinFromAtlas(*atlas);
+                skinChanged = true;
+            };
+            return true;
+        });
+        assets.submit([&](TextureUpload& upload) {
+            auto bitmap = std::make_shared<FontBitmap>();
+            if (!bakeFont("arial.ttf", 48.0f, *bitmap)) return false;
+            upload.width = upload.height = bitmap->size;
+            upload.rgba = std::move(bitmap->rgba);
+            upload.onReady = [&, bitmap](GLuint tex) { font.adopt(std::move(*bitmap), tex); };
+            return true;
+        });
+    }
+
+    WorldConfig worldConfig;
+    worldConfig.width = (float)WINDOW_W;
+    worldConfig.height = (float)WINDOW_H;
+    worldConfig.seed = seed;
+    worldConfig.level = level;
+    GameWorld world(worldConfig);
+    JobSystem jobs;
+    world.jobs = &jobs;
+
+    renderer.bricks.upload(world.bricks, skin);
+    FrameArena frameArena;
+    RenderQueue renderQueue;
+    ParticleSystem particles(ParticleConfig(), seed);
+
+    FixedStepClock simClock(simHz, maxCatchUp);
+    ReplayRecorder recorder;
+    if (!recordPath.empty()) recorder.begin(worldConfig, simHz);
+    const float stepDt = (float)simClock.stepSeconds;
+    int stressSteps = 0;
 
     double lastTime = glfwGetTime();
-    glUseProgram(program);
-    glUniformMatrix4fv(loc_projection, 1, GL_FALSE, &proj[0][0]);
-    glUniform1i(loc_tex, 0);
-
-    auto drawSprite = [&](const Sprite& s) {
-        glm::mat4 model = glm::mat4(1.0f);
-        model = glm::translate(model, glm::vec3(s.pos, s.depth));
-        model = glm::scale(model, glm::vec3(s.size, 1.0f));
-        glUniformMatrix4fv(loc_model, 1, GL_FALSE, &model[0][0]);
-        glUniform4fv(loc_color, 1, &s.color[0]);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, s.tex);
-        glBindVertexArray(VAO);
-        glDrawArrays(GL_TRIANGLES, 0, 6);
-        };
+    double statsTime = lastTime;
+    int statsFrames = 0;
+    size_t maxFrameAllocs = 0;
+    bool firstFrameShown = false, assetsReported = false;
+    std::string fpsText = "FPS --";
+    ProfilerOverlay overlay;
+    bool showOverlay = false, f3Down = false, f4Down = false;
+    FrameScene scene;
+    scene.world = &world;
+    scene.queue = &renderQueue;
+    scene.particles = &particles;
+    scene.font = &font;
+    scene.fpsText = &fpsText;
+    scene.viewport = glm::vec2((float)WINDOW_W, (float)WINDOW_H);
+    scene.proj = proj;
+    // Setup above bound vertex arrays and textures directly.
+    device.invalidate();
 
     while (!glfwWindowShouldClose(window)) {
+        // The previous frame's zones have all closed by now.
+        profiler.endFrame();
+        PROFILE_ZONE("frame");
         double now = glfwGetTime();
-        float dt = (float)(now - lastTime);
+        double frameTime = now - lastTime;
         lastTime = now;
-        glfwPollEvents();
-
-        if (!gameOver && !youWin) {
-            double xpos, ypos;
-            glfwGetCursorPos(window, &xpos, &ypos);
-            paddle.pos.x = (float)xpos - paddle.size.x / 2.0f;
-            if (paddle.pos.x < 0) paddle.pos.x = 0;
-            if (paddle.pos.x + paddle.size.x > WINDOW_W) paddle.pos.x = WINDOW_W - paddle.size.x;
-
-            for (auto& pu : powerUps) {
-                if (!pu.active) continue;
-                pu.pos += pu.vel * dt;
-                if (pu.pos.y < -pu.size.y) {
-                    pu.active = false;
-                }
-            }
-
-            powerUps.erase(std::remove_if(powerUps.begin(), powerUps.end(),
-                [](const PowerUp& pu) { return !pu.active; }), powerUps.end());
-
-            bool ballLost = false;
-            for (auto& ball : balls) {
-                ball.pos += ball.vel * dt;
-                if (ball.pos.x - ball.radius < 0) { ball.pos.x = ball.radius; ball.vel.x *= -1; }
-                if (ball.pos.x + ball.radius > WINDOW_W) { ball.pos.x = WINDOW_W - ball.radius; ball.vel.x *= -1; }
-                if (ball.pos.y + ball.radius > WINDOW_H) { ball.pos.y = WINDOW_H - ball.radius; ball.vel.y *= -1; }
-
-                if (ball.pos.y - ball.radius < 0) {
-                    ballLost = true;
-                    break;
-                }
-
-                glm::vec2 closest;
-                if (AABBvsCircle(paddle.pos, paddle.size, ball.pos, ball.radius, closest)) {
-                    ball.vel.y = fabs(ball.vel.y);
-                    float hitNorm = (ball.pos.x - (paddle.pos.x + paddle.size.x * 0.5f)) / (paddle.size.x * 0.5f);
-                    ball.vel.x += hitNorm * 150.0f;
-                }
-
-                for (auto& b : bricks) {
-                    if (!b.alive) continue;
-                    if (AABBvsCircle(b.s.pos, b.s.size, ball.pos, ball.radius, closest)) {
-                        b.alive = false;
-                        glm::vec2 diff = ball.pos - closest;
-                        if (fabs(diff.x) > fabs(diff.y)) ball.vel.x *= -1.0f;
-                        else ball.vel.y *= -1.0f;
-
-                        if (rand() % 100 < 30) {
-                            PowerUp pu;
-                            pu.pos = glm::vec2(b.s.pos.x + b.s.size.x * 0.5f, b.s.pos.y);
-                            pu.vel = glm::vec2(0.0f, -100.0f);
-                            pu.size = glm::vec2(30.0f, 30.0f);
-                            pu.type = (PowerUpType)(rand() % 2); 
-                            pu.active = true;
-                            pu.tex = (pu.type == MULTIBALL) ? tex_ball : tex_heart;
-                            powerUps.push_back(pu);
-                        }
-                        break;
-                    }
-                }
-            }
-
-            if (ballLost) {
-                balls.erase(std::remove_if(balls.begin(), balls.end(),
-                    [](const Ball& b) { return b.pos.y - b.radius < 0; }), balls.end());
-
-                if (balls.empty()) {
-                    lives--;
-                    if (lives <= 0) {
-                        gameOver = true;
-                    }
-                    else {
-                        Ball newBall;
-                        newBall.radius = 10.0f;
-                        newBall.pos = glm::vec2(WINDOW_W / 2.0f, 200.0f);
-                        newBall.vel = glm::vec2(200.0f, 200.0f);
-                        newBall.tex = tex_ball;
-                        balls.push_back(newBall);
-                    }
-                }
-            }
-
-            for (auto& pu : powerUps) {
-                if (!pu.active) continue;
-                if (pu.pos.x + pu.size.x > paddle.pos.x &&
-                    pu.pos.x < paddle.pos.x + paddle.size.x &&
-                    pu.pos.y + pu.size.y > paddle.pos.y &&
-                    pu.pos.y < paddle.pos.y + paddle.size.y) {
-
-                    if (pu.type == MULTIBALL) {
-                        std::vector<Ball> newBalls;
-                        int ballsToCreate = std::min(3, (int)balls.size());
-                        for (int i = 0; i < ballsToCreate; i++) {
-                            const Ball& existingBall = balls[i % balls.size()];
-                            Ball newBall = existingBall;
-                            float baseAngle = atan2(existingBall.vel.y, existingBall.vel.x);
-                            float angleOffset = ((rand() % 90) - 45) * 3.14159f / 180.0f;
-                            float newAngle = baseAngle + angleOffset;
-                            float speed = glm::length(existingBall.vel);
-                            newBall.vel.x = cos(newAngle) * speed;
-                            newBall.vel.y = sin(newAngle) * speed;
-                            if (newBall.vel.y < 0) newBall.vel.y = -newBall.vel.y;
-                            newBalls.push_back(newBall);
-                        }
-                        balls.insert(balls.end(), newBalls.begin(), newBalls.end());
-                    }
-                    else if (pu.type == EXTRALIFE) {
-                        lives++;
-                    }
-
-                    pu.active = false;
-                }
-            }
+        {
+            PROFILE_ZONE("input");
+            glfwPollEvents();
+        }
+        if (keys[GLFW_KEY_F3] && !f3Down) {
+            showOverlay = !showOverlay;
+            if (showOverlay) overlay.refresh(font);
+        }
+        if (keys[GLFW_KEY_F4] && !f4Down && !profiler.tracing()) profiler.startTrace(tracePath, kTraceFrames);
+        f3Down = keys[GLFW_KEY_F3];
+        f4Down = keys[GLFW_KEY_F4];
+        renderStats.reset();
+        frameArena.reset();
+        AllocCounters frameStart = allocCounters();
+
+        device.resetCounters();
+        int uploadFrames = assets.pumpsUploading;
+        assets.pump(kAssetUploadBudgetMs);
+        if (assets.pumpsUploading != uploadFrames) device.invalidate();
+        if (skinChanged) {
+            renderer.bricks.upload(world.bricks, skin);
+            skinChanged = false;
+        }
 
-            bool allDestroyed = true;
-            for (const auto& b : bricks) {
-                if (b.alive) {
-                    allDestroyed = false;
-                    break;
-                }
+        double xpos, ypos;
+        glfwGetCursorPos(window, &xpos, &ypos);
+        GameInput input;
+        input.paddleX = (float)xpos;
+        int steps = simClock.advance(frameTime);
+        {
+            PROFILE_ZONE("simulation");
+            for (int i = 0; i < steps; ++i) {
+                world.step(stepDt, input);
+                renderer.bricks.patch(world.bricks, world.killedBricks);
+                for (int brick : world.killedBricks)
+                    particles.emit(world.bricks.pos(brick) + world.bricks.extent(brick) * 0.5f, world.bricks.color[brick], 48);
+                if (!recordPath.empty()) recorder.record(input, world);
             }
-            if (allDestroyed) {
-                youWin = true;
+        }
+        float alpha = simClock.alpha();
+
+        if (stressMode) {
+            // Step a scratch copy for one 60 Hz frame budget to see how many
+            // simulation steps this machine could afford per frame.
+            GameWorld probe = world;
+            double budgetEnd = glfwGetTime() + 1.0 / 60.0;
+            stressSteps = 0;
+            while (glfwGetTime() < budgetEnd) {
+                for (int i = 0; i < 64; ++i) probe.step(stepDt, input);
+                stressSteps += 64;
+                if (probe.gameOver || probe.youWin) probe = world;
             }
         }
 
-        std::vector<Sprite> opaqueSprites;
-        std::vector<Sprite> transparentSprites;
-
-        Sprite spP;
-        spP.pos = paddle.pos; spP.size = paddle.size; spP.tex = paddle.tex;
-        spP.color = glm::vec4(1.0f); spP.transparent = false; spP.depth = 0.0f;
-        opaqueSprites.push_back(spP);
-
-        for (auto& b : bricks) {
-            if (!b.alive) continue;
-            Sprite sb = b.s;
-            sb.depth = 0.0f;
-            sb.transparent = false;
-            opaqueSprites.push_back(sb);
-        }
+        particles.update((float)std::min(frameTime, 0.1));
+        queueWorld(world, alpha, skin, frameArena, renderQueue);
 
-        for (const auto& ball : balls) {
-            Sprite spB;
-            spB.pos = ball.pos - glm::vec2(ball.radius);
-            spB.size = glm::vec2(ball.radius * 2.0f);
-            spB.tex = ball.tex;
-            spB.color = glm::vec4(1.0f);
-            spB.transparent = true;
-            spB.depth = 0.0f;
-            transparentSprites.push_back(spB);
-        }
+        scene.skin = skin;
+        scene.overlay = showOverlay ? &overlay : nullptr;
+        renderer.submit(scene, &gpuTimer);
 
-        for (const auto& pu : powerUps) {
-            if (!pu.active) continue;
-            Sprite spPU;
-            spPU.pos = pu.pos;
-            spPU.size = pu.size;
-            spPU.tex = pu.tex;
-            spPU.color = glm::vec4(1.0f, 1.0f, 0.5f, 1.0f); 
-            spPU.transparent = true;
-            spPU.depth = 0.0f;
-            transparentSprites.push_back(spPU);
+        {
+            PROFILE_ZONE("swap");
+            glfwSwapBuffers(window);
         }
 
-        std::sort(transparentSprites.begin(), transparentSprites.end(), [](const Sprite& a, const Sprite& b) {
-            if (a.depth != b.depth) return a.depth > b.depth;
-            return a.pos.y > b.pos.y;
-            });
-
-        glClearColor(0.08f, 0.08f, 0.12f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        glUseProgram(program);
-        for (auto& s : opaqueSprites) drawSprite(s);
-        for (auto& s : transparentSprites) drawSprite(s);
-        float heartSize = 32.0f;
-        float heartSpacing = 40.0f;
-        for (int i = 0; i < lives; i++) {
-            Sprite heart;
-            heart.pos = glm::vec2(20.0f + i * heartSpacing, WINDOW_H - 50.0f);
-            heart.size = glm::vec2(heartSize, heartSize);
-            heart.tex = tex_heart;
-            heart.transparent = true;
-            drawSprite(heart);
+        if (!firstFrameShown || (!assetsReported && assets.idle())) {
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+            if (!firstFrameShown)
+                std::cout << "First frame after " << ms << " ms (" << (syncAssets ? "sync" : "async") << " assets)\n";
+            if (assets.idle()) {
+                std::cout << "All assets resident after " << ms << " ms (" << assets.texturesReady << " uploads, "
+                    << assets.uploadedBytes / 1024 << " KiB over " << assets.pumpsUploading << " frames)\n";
+                assetsReported = true;
+            }
+            firstFrameShown = true;
         }
 
-        if (gameOver) {
-            drawRect(0, 0, WINDOW_W, WINDOW_H, glm::vec4(0.0f, 0.0f, 0.0f, 0.7f), rectProgram, rectVAO, proj);
-            float scale = 1.5f;
-            glm::vec2 textSize = getTextSize("GAME OVER", scale);
-            float x = (WINDOW_W - textSize.x) / 2.0f;
-            float y = (WINDOW_H - textSize.y) / 2.0f;
-            drawBigText("GAME OVER", x, y, scale, glm::vec4(1.0f, 0.1f, 0.1f, 1.0f), rectProgram, rectVAO, proj);
-
+        // The stress probe copies the world, so only count the regular path.
+        if (!stressMode) {
+            size_t frameAllocs = allocCounters().allocations - frameStart.allocations;
+            maxFrameAllocs = std::max(maxFrameAllocs, frameAllocs);
         }
 
-        if (youWin) {
-            drawRect(0, 0, WINDOW_W, WINDOW_H, glm::vec4(0.0f, 0.0f, 0.0f, 0.7f), rectProgram, rectVAO, proj);
-            drawBigText("YOU WIN!", 150.0f, WINDOW_H / 2.0f - 35.0f, 1.5f,
-                glm::vec4(0.0f, 1.0f, 0.0f, 1.0f), rectProgram, rectVAO, proj);
+        statsFrames++;
+        if (now - statsTime > 0.5) {
+            fpsText = "FPS " + std::to_string((int)(statsFrames / (now - statsTime) + 0.5));
+            statsFrames = 0;
+            statsTime = now;
+            std::string title = "Arkanoid Prototype | draws " + std::to_string(renderStats.drawCalls) +
+                " | uniforms " + std::to_string(renderStats.uniformUploads) +
+                " | filtered " + std::to_string(device.filteredTotal()) +
+                " | sprites " + std::to_string(renderStats.instances) +
+                " | upload " + std::to_string(renderStats.bytesUploaded / 1024) + " KiB" +
+                " | allocs " + std::to_string(maxFrameAllocs) +
+                " | particles " + std::to_string(particles.liveCount()) +
+                " | sim " + std::to_string((int)simHz) + " Hz";
+            if (stressMode)
+                title += " | capacity " + std::to_string(stressSteps) + " steps/frame" +
+                    " | behind " + std::to_string(simClock.droppedFrames) + " frames";
+            glfwSetWindowTitle(window, title.c_str());
+            maxFrameAllocs = 0;
+            if (showOverlay) overlay.refresh(font);
         }
-
-        glfwSwapBuffers(window);
     }
 
     glfwTerminate();
+    if (!recordPath.empty()) {
+        if (saveReplay(recordPath, recorder.replay()))
+            std::cout << "Replay saved to " << recordPath << " (seed " << seed << ", "
+                << recorder.replay().inputs.size() << " steps)" << std::endl;
+        else
+            std::cout << "Failed to save replay: " << recordPath << std::endl;
+    }
     return 0;
 }
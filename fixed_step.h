@@ -0,0 +1,29 @@
+#pragma once
+
+// Accumulates wall-clock frame time and hands it out as whole simulation
+// steps of a fixed length. When the machine falls behind, at most maxSteps are
+// run per frame and the remaining backlog is dropped instead of snowballing.
+struct FixedStepClock {
+    double stepSeconds = 1.0 / 240.0;
+    int maxSteps = 8;
+    double accumulator = 0.0;
+    int droppedFrames = 0;   // frames that hit maxSteps and lost backlog; --stress shows it
+
+    explicit FixedStepClock(double hz = 240.0, int maxCatchUp = 8)
+        : stepSeconds(1.0 / hz), maxSteps(maxCatchUp) {}
+
+    int advance(double frameSeconds) {
+        accumulator += frameSeconds;
+        int steps = (int)(accumulator / stepSeconds);
+        if (steps > maxSteps) {
+            steps = maxSteps;
+            accumulator = stepSeconds * maxSteps;
+            droppedFrames++;
+        }
+        accumulator -= steps * stepSeconds;
+        return steps;
+    }
+
+    // Blend factor between the previous and the current simulation state.
+    float alpha() const { return (float)(accumulator / stepSeconds); }
+};
@@ -0,0 +1,132 @@
+#include "font.h"
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include "stb_truetype.h"
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+namespace {
+
+const int kFontTexSize = 512;
+// Enough for a screen of static labels; the cache is simply dropped when full.
+const size_t kMaxCachedLayouts = 256;
+
+}
+
+bool bakeFont(const std::string& path, float pixelHeight, FontBitmap& out) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<unsigned char> ttf((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (ttf.empty()) {
+        std::cout << "Failed to load font: " << path << std::endl;
+        return false;
+    }
+
+    stbtt_fontinfo info;
+    if (!stbtt_InitFont(&info, ttf.data(), stbtt_GetFontOffsetForIndex(ttf.data(), 0))) {
+        std::cout << "Failed to parse font: " << path << std::endl;
+        return false;
+    }
+    int asc, desc, gap;
+    stbtt_GetFontVMetrics(&info, &asc, &desc, &gap);
+    float s = stbtt_ScaleForPixelHeight(&info, pixelHeight);
+    out.height = pixelHeight;
+    out.ascent = asc * s;
+    out.descent = desc * s;
+
+    std::vector<unsigned char> coverage((size_t)kFontTexSize * kFontTexSize);
+    stbtt_bakedchar baked[kLastChar - kFirstChar + 1];
+    if (stbtt_BakeFontBitmap(ttf.data(), 0, pixelHeight, coverage.data(), kFontTexSize, kFontTexSize,
+        kFirstChar, kLastChar - kFirstChar + 1, baked) <= 0)
+        std::cout << "Font atlas too small for " << path << " at " << pixelHeight << "px" << std::endl;
+
+    // The bitmap is y-down; quads are y-up, so v runs from the bottom row to the top.
+    out.glyphs.assign(kLastChar - kFirstChar + 1, Glyph());
+    for (int i = 0; i <= kLastChar - kFirstChar; ++i) {
+        const stbtt_bakedchar& b = baked[i];
+        Glyph& g = out.glyphs[i];
+        g.size = glm::vec2(b.x1 - b.x0, b.y1 - b.y0);
+        g.offset = glm::vec2(b.xoff, -(b.yoff + g.size.y));
+        g.advance = b.xadvance;
+        g.uv = glm::vec4((float)b.x0 / kFontTexSize, (float)b.y1 / kFontTexSize,
+            (float)b.x1 / kFontTexSize, (float)b.y0 / kFontTexSize);
+    }
+
+    // White RGBA with coverage in alpha, so the regular sprite shader can tint it.
+    out.size = kFontTexSize;
+    out.rgba.assign(coverage.size() * 4, 255);
+    for (size_t i = 0; i < coverage.size(); ++i) out.rgba[i * 4 + 3] = coverage[i];
+    return true;
+}
+
+void Font::adopt(FontBitmap&& bitmap, GLuint texture) {
+    tex = texture;
+    height = bitmap.height;
+    ascent = bitmap.ascent;
+    descent = bitmap.descent;
+    glyphs = std::move(bitmap.glyphs);
+    // Anything laid out before the glyphs arrived is empty.
+    cache.clear();
+}
+
+void Font::layout(const std::string& text, TextLayout& out) const {
+    out.quads.clear();
+    out.width = 0.0f;
+    out.ascent = ascent;
+    out.descent = descent;
+    if (glyphs.empty()) return;
+
+    float penX = 0.0f;
+    for (char ch : text) {
+        int c = (unsigned char)ch;
+        if (c < kFirstChar || c > kLastChar) c = '?';
+        const Glyph& g = glyphs[c - kFirstChar];
+        if (g.size.x > 0.0f && g.size.y > 0.0f) {
+            GlyphQuad q;
+            q.rect = glm::vec4(penX + g.offset.x, g.offset.y, g.size.x, g.size.y);
+            q.uv = g.uv;
+            out.quads.push_back(q);
+        }
+        penX += g.advance;
+    }
+    out.width = penX;
+}
+
+const TextLayout& Font::cached(const std::string& text) {
+    auto it = cache.find(text);
+    if (it != cache.end()) {
+        cacheHits++;
+        return it->second;
+    }
+    cacheMisses++;
+    if (cache.size() >= kMaxCachedLayouts) cache.clear();
+    TextLayout& entry = cache[text];
+    layout(text, entry);
+    return entry;
+}
+
+const TextLayout& TextLabel::set(const Font& font, const std::string& s) {
+    // Layouts made before the font arrived are empty; the new texture says so.
+    if (laidOut && s == text && tex == font.texture()) return layout;
+    text = s;
+    tex = font.texture();
+    laidOut = true;
+    font.layout(text, layout);
+    return layout;
+}
+
+void drawText(SpriteBatch& batch, const Font& font, const TextLayout& text, const glm::vec2& pos,
+    float scale, const glm::vec4& color)
+{
+    Sprite s;
+    s.tex = font.texture();
+    s.color = color;
+    s.transparent = true;
+    for (const GlyphQuad& q : text.quads) {
+        s.pos = pos + glm::vec2(q.rect.x, q.rect.y) * scale;
+        s.size = glm::vec2(q.rect.z, q.rect.w) * scale;
+        s.uv = q.uv;
+        batch.add(s);
+    }
+}
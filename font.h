@@ -0,0 +1,97 @@
+#pragma once
+
+#include "sprite_batch.h"
+
+#include <glad.h>
+#include <glm.hpp>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct Glyph {
+    glm::vec4 uv = glm::vec4(0.0f);   // u0, v0, u1, v1 in the font texture
+    glm::vec2 offset = glm::vec2(0.0f);   // bottom-left corner relative to the pen on the baseline
+    glm::vec2 size = glm::vec2(0.0f);
+    float advance = 0.0f;
+};
+
+struct GlyphQuad {
+    glm::vec4 rect;   // x, y, w, h relative to the string origin
+    glm::vec4 uv;
+};
+
+// A string laid out at the baked pixel size, with the baseline at y = 0.
+struct TextLayout {
+    std::vector<GlyphQuad> quads;
+    float width = 0.0f;
+    float ascent = 0.0f;
+    float descent = 0.0f;   // negative, below the baseline
+};
+
+// The characters a font bakes; anything else is drawn as '?'.
+const int kFirstChar = 32;
+const int kLastChar = 126;
+
+// A baked font before it has a texture: RGBA pixels (white, coverage in
+// alpha) and the glyph metrics, one glyph per character from kFirstChar.
+struct FontBitmap {
+    int size = 0;   // texture width and height
+    std::vector<unsigned char> rgba;
+    std::vector<Glyph> glyphs;
+    float height = 0.0f;
+    float ascent = 0.0f, descent = 0.0f;
+};
+
+// The CPU half of Font::load. Safe to call off the main thread.
+bool bakeFont(const std::string& path, float pixelHeight, FontBitmap& out);
+
+// Printable ASCII baked once into a single texture with stb_truetype. Text is
+// drawn through a SpriteBatch, so one string costs at most one draw call.
+class Font {
+public:
+    // Bakes and uploads in one go; the only part of Font that calls GL (font_gl.cpp).
+    bool load(const std::string& path, float pixelHeight);
+    // Takes over a baked font whose pixels are already in `texture`. Until
+    // then, layouts are empty.
+    void adopt(FontBitmap&& bitmap, GLuint texture);
+
+    GLuint texture() const { return tex; }
+    float pixelHeight() const { return height; }
+
+    void layout(const std::string& text, TextLayout& out) const;
+    // Layouts are kept between frames, so static labels are only shaped once.
+    // The cache is dropped whenever it fills up and on adopt(), so the
+    // reference is only good until the next call to either; draw with it
+    // straight away. Text that changes from frame to frame (scores,
+    // counters) belongs in a TextLabel, or it would keep refilling the cache.
+    const TextLayout& cached(const std::string& text);
+
+    int cacheHits = 0;
+    int cacheMisses = 0;
+
+private:
+    GLuint tex = 0;
+    float height = 0.0f;
+    float ascent = 0.0f, descent = 0.0f;
+    std::vector<Glyph> glyphs;   // kFirstChar .. kLastChar
+    std::unordered_map<std::string, TextLayout> cache;
+};
+
+// A caller-owned layout for one piece of changing text. set() lays the
+// string out again only when it, or the font's texture, differs from last
+// time; the layout stays valid for as long as the label lives.
+struct TextLabel {
+    std::string text;
+    TextLayout layout;
+
+    const TextLayout& set(const Font& font, const std::string& s);
+
+private:
+    GLuint tex = 0;
+    bool laidOut = false;
+};
+
+// Queues a laid-out string with its baseline starting at `pos`.
+void drawText(SpriteBatch& batch, const Font& font, const TextLayout& text, const glm::vec2& pos,
+    float scale, const glm::vec4& color);
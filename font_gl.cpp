@@ -0,0 +1,18 @@
+#include "font.h"
+
+bool Font::load(const std::string& path, float pixelHeight) {
+    FontBitmap bitmap;
+    if (!bakeFont(path, pixelHeight, bitmap)) return false;
+
+    GLuint texture;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, bitmap.size, bitmap.size, 0, GL_RGBA, GL_UNSIGNED_BYTE, bitmap.rgba.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    adopt(std::move(bitmap), texture);
+    return true;
+}
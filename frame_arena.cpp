@@ -0,0 +1,31 @@
+#include "frame_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+FrameArena::FrameArena(size_t bytes) : block(bytes) {}
+
+void* FrameArena::alloc(size_t bytes, size_t align) {
+    uintptr_t base = (uintptr_t)block.data();
+    size_t start = (size_t)(((base + offset + align - 1) & ~(uintptr_t)(align - 1)) - base);
+    if (start + bytes <= block.size()) {
+        offset = start + bytes;
+        peak = std::max(peak, used());
+        return block.data() + start;
+    }
+
+    overflow.emplace_back(new unsigned char[bytes + align]);
+    overflowBytes += bytes + align;
+    peak = std::max(peak, used());
+    uintptr_t p = (uintptr_t)overflow.back().get();
+    return (void*)((p + align - 1) & ~(uintptr_t)(align - 1));
+}
+
+void FrameArena::reset() {
+    if (!overflow.empty()) {
+        overflow.clear();
+        block.assign(std::max(block.size() * 2, peak), 0);
+    }
+    offset = 0;
+    overflowBytes = 0;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// Linear allocator for data that only lives until the end of the frame.
+// reset() releases everything at once. If a frame outgrows the block, the
+// extra requests spill to the heap and the block is grown at the next reset,
+// so steady-state frames never touch the heap.
+class FrameArena {
+public:
+    explicit FrameArena(size_t bytes = 64 * 1024);
+
+    void* alloc(size_t bytes, size_t align);
+    template <typename T>
+    T* allocArray(size_t n) { return static_cast<T*>(alloc(n * sizeof(T), alignof(T))); }
+
+    void reset();
+
+    size_t used() const { return offset + overflowBytes; }
+    size_t capacity() const { return block.size(); }
+    size_t highWater() const { return peak; }
+
+private:
+    std::vector<unsigned char> block;
+    size_t offset = 0;
+    size_t peak = 0;
+    std::vector<std::unique_ptr<unsigned char[]>> overflow;
+    size_t overflowBytes = 0;
+};
@@ -0,0 +1,130 @@
+#include "frame_renderer.h"
+
+#include <algorithm>
+#include <cstdio>
+
+void ProfilerOverlay::refresh(const Font& font) {
+    rows.assign(profiler.zones().begin(),
+        profiler.zones().begin() + std::min<size_t>(profiler.zones().size(), kMaxRows));
+    cells.resize(4 * (rows.size() + 1));
+    const char* header[4] = { "zone", "last", "mean", "p95 ms" };
+    for (int c = 0; c < 4; ++c) font.layout(header[c], cells[c]);
+    char buf[32];
+    for (size_t r = 0; r < rows.size(); ++r) {
+        TextLayout* row = &cells[4 * (r + 1)];
+        font.layout(rows[r].name, row[0]);
+        std::snprintf(buf, sizeof(buf), "%.2f", rows[r].last() * 1e-3f);
+        font.layout(buf, row[1]);
+        std::snprintf(buf, sizeof(buf), "%.2f", rows[r].mean() * 1e-3f);
+        font.layout(buf, row[2]);
+        std::snprintf(buf, sizeof(buf), "%.2f", rows[r].percentile(0.95f) * 1e-3f);
+        font.layout(buf, row[3]);
+    }
+}
+
+void ProfilerOverlay::draw(SpriteBatch& sprites, RectBatch& rects, const Font& font, const glm::mat4& proj,
+    float top) const
+{
+    const float rowH = 16.0f, left = 10.0f, histX = 300.0f, binW = 5.0f;
+    const float columns[4] = { 0.0f, 120.0f, 180.0f, 240.0f };
+    rects.add(left - 5.0f, top - rowH * (rows.size() + 1) - 5.0f, histX + binW * ZoneStats::kBins,
+        rowH * (rows.size() + 1) + 5.0f, glm::vec4(0.0f, 0.0f, 0.0f, 0.6f));
+    for (size_t r = 0; r < rows.size(); ++r) {
+        float y = top - rowH * (r + 2);
+        for (int b = 0; b < ZoneStats::kBins; ++b) {
+            if (!rows[r].bins[b]) continue;
+            float h = std::max(1.0f, (rowH - 4.0f) * rows[r].bins[b] / rows[r].frames);
+            rects.add(left + histX + b * binW, y + 2.0f, binW - 1.0f, h, glm::vec4(0.3f, 0.8f, 1.0f, 0.9f));
+        }
+    }
+    rects.flush(proj);
+    for (size_t i = 0; i < cells.size(); ++i) {
+        float y = top - rowH * (i / 4 + 1) + 4.0f;
+        drawText(sprites, font, cells[i], glm::vec2(left + columns[i % 4], y), 0.25f, glm::vec4(1.0f));
+    }
+    sprites.flush();
+}
+
+bool FrameRenderer::init(RenderDevice& dev, GLuint spriteProgram, GLuint rectProgram, GLuint quadVAO,
+    GLuint brickVAO, GLuint particleVAO, GLuint rectVAO, int particleCapacity)
+{
+    device = &dev;
+    bool ok = sprites.init(dev, spriteProgram, quadVAO, 4096);
+    ok = rects.init(dev, rectProgram, rectVAO, 4096) && ok;
+    ok = bricks.init(dev, spriteProgram, brickVAO) && ok;
+    // Sized to the particle capacity so every live particle goes out in one draw.
+    ok = particleBatch.init(dev, spriteProgram, particleVAO, particleCapacity, 1) && ok;
+    return ok;
+}
+
+void FrameRenderer::submit(const FrameScene& scene, PassTimer* timer) {
+    PROFILE_ZONE("submit");
+    const GameWorld& world = *scene.world;
+    const glm::mat4& proj = scene.proj;
+    const float width = scene.viewport.x, height = scene.viewport.y;
+    Font& font = *scene.font;
+    auto beginPass = [timer](const char* pass) { if (timer) timer->begin(pass); };
+    auto endPass = [timer]() { if (timer) timer->end(); };
+
+    if (timer) timer->beginFrame();
+    beginPass("gpu clear");
+    device->clear(glm::vec4(0.08f, 0.08f, 0.12f, 1.0f));
+    endPass();
+
+    sprites.begin(proj);
+    rects.begin();
+    beginPass("gpu bricks");
+    bricks.draw();
+    endPass();
+    beginPass("gpu particles");
+    particleBatch.begin(proj);
+    const ParticleSystem& particles = *scene.particles;
+    particles.writeInstances(particleBatch.reserve(scene.skin.tex, (int)particles.liveCount()), scene.skin.ball);
+    particleBatch.flush();
+    endPass();
+
+    // Paddle, balls, power-ups, hearts and HUD text share one batch.
+    beginPass("gpu sprites");
+    for (int i = 0; i < scene.queue->count; ++i) sprites.add((*scene.queue)[i]);
+    float heartSize = 32.0f;
+    float heartSpacing = 40.0f;
+    for (int i = 0; i < world.lives; i++) {
+        Sprite heart;
+        heart.pos = glm::vec2(20.0f + i * heartSpacing, height - 50.0f);
+        heart.size = glm::vec2(heartSize, heartSize);
+        heart.tex = scene.skin.tex;
+        heart.uv = scene.skin.heart;
+        heart.transparent = true;
+        sprites.add(heart);
+    }
+    const TextLayout& scoreText = scoreLabel.set(font, "SCORE " + std::to_string(world.score));
+    drawText(sprites, font, scoreText, glm::vec2(width - 20.0f - scoreText.width * 0.6f, height - 45.0f),
+        0.6f, glm::vec4(1.0f));
+    drawText(sprites, font, fpsLabel.set(font, *scene.fpsText), glm::vec2(width - 120.0f, 12.0f),
+        0.35f, glm::vec4(0.7f, 0.7f, 0.7f, 1.0f));
+    sprites.flush();
+    endPass();
+
+    const char* banner = nullptr;
+    glm::vec4 bannerColor(1.0f);
+    if (world.gameOver) {
+        banner = "GAME OVER";
+        bannerColor = glm::vec4(1.0f, 0.1f, 0.1f, 1.0f);
+    }
+    else if (world.youWin) {
+        banner = "YOU WIN!";
+        bannerColor = glm::vec4(0.0f, 1.0f, 0.0f, 1.0f);
+    }
+    beginPass("gpu overlays");
+    if (banner) {
+        rects.add(0, 0, width, height, glm::vec4(0.0f, 0.0f, 0.0f, 0.7f));
+        rects.flush(proj);
+        float scale = 2.0f;
+        const TextLayout& text = font.cached(banner);
+        glm::vec2 pos((width - text.width * scale) / 2.0f, (height - (text.ascent + text.descent) * scale) / 2.0f);
+        drawText(sprites, font, text, pos, scale, bannerColor);
+        sprites.flush();
+    }
+    if (scene.overlay) scene.overlay->draw(sprites, rects, font, proj, height - 70.0f);
+    endPass();
+}
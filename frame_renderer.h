@@ -0,0 +1,62 @@
+#pragma once
+
+#include "font.h"
+#include "game_world.h"
+#include "particles.h"
+#include "profiler.h"
+#include "rect_batch.h"
+#include "render_device.h"
+#include "render_queue.h"
+#include "sprite_batch.h"
+
+#include <glad.h>
+#include <glm.hpp>
+
+#include <string>
+#include <vector>
+
+// The F3 overlay: per zone, the last, mean and 95th percentile cost in ms and
+// the histogram over the profiler window. Refreshed with the title, so the
+// text is laid out twice a second rather than every frame.
+struct ProfilerOverlay {
+    static const int kMaxRows = 16;
+    std::vector<ZoneStats> rows;
+    std::vector<TextLayout> cells;   // header, then four per row
+
+    void refresh(const Font& font);
+    void draw(SpriteBatch& sprites, RectBatch& rects, const Font& font, const glm::mat4& proj, float top) const;
+};
+
+// Everything a frame draws besides the batches' own state.
+struct FrameScene {
+    const GameWorld* world = nullptr;
+    const RenderQueue* queue = nullptr;   // sorted
+    const ParticleSystem* particles = nullptr;
+    SpriteSkin skin;
+    Font* font = nullptr;
+    const std::string* fpsText = nullptr;
+    const ProfilerOverlay* overlay = nullptr;   // null while hidden
+    glm::vec2 viewport = glm::vec2(800.0f, 600.0f);
+    glm::mat4 proj = glm::mat4(1.0f);
+};
+
+// The batches main() draws with, and the one function that submits a frame
+// through them. The benchmarks drive the same function on a null device, so
+// what they count is what the game submits.
+struct FrameRenderer {
+    SpriteBatch sprites;   // paddle, balls, power-ups, hearts and text
+    SpriteBatch particleBatch;
+    RectBatch rects;
+    BrickInstanceBuffer bricks;
+
+    // Bricks and particles need vertex arrays of their own; `quadVAO` is the
+    // sprite batch's.
+    bool init(RenderDevice& device, GLuint spriteProgram, GLuint rectProgram, GLuint quadVAO, GLuint brickVAO,
+        GLuint particleVAO, GLuint rectVAO, int particleCapacity);
+    // Clears and draws one frame. Passes are bracketed with `timer` if given.
+    void submit(const FrameScene& scene, PassTimer* timer = nullptr);
+
+private:
+    RenderDevice* device = nullptr;
+    TextLabel scoreLabel, fpsLabel;   // change with the game; banners go through the font cache
+};
@@ -0,0 +1,428 @@
+#include "game_world.h"
+#include "collision.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+GameWorld::GameWorld(const WorldConfig& cfg) : config(cfg), rng(cfg.seed, cfg.stream) {
+    reset();
+}
+
+void GameWorld::reset() {
+    paddle.size = glm::vec2(120.0f, 20.0f);
+    paddle.pos = glm::vec2(config.width / 2.0f - paddle.size.x / 2.0f, 50.0f);
+    paddle.prevPos = paddle.pos;
+
+    balls.reserve((uint32_t)config.maxBalls);
+    spawnBall();
+    powerUps.reserve((uint32_t)config.maxPowerUps);
+    lives = config.lives;
+    score = 0;
+    gameOver = false;
+    youWin = false;
+
+    buildBricks();
+}
+
+void GameWorld::buildBricks() {
+    bricks.clear();
+    if (config.level) {
+        bricks.attach(config.level->bricks(), config.level);
+    }
+    else {
+        float margin = 10.0f;
+        float brickW = (config.width - (config.cols + 1) * margin) / config.cols;
+        float brickH = 30.0f;
+        for (int r = 0; r < config.rows; ++r) {
+            for (int c = 0; c < config.cols; ++c) {
+                glm::vec2 pos(margin + c * (brickW + margin), config.height - (r + 1) * (brickH + 20.0f));
+                glm::vec4 color(1.0f - r * 0.12f, 0.2f + r * 0.12f, 0.3f + c * 0.01f, 1.0f);
+                bricks.add(pos, glm::vec2(brickW, brickH), color, r);
+            }
+        }
+    }
+
+    std::vector<BrickBounds> bounds;
+    for (size_t i = 0; i < bricks.count(); ++i)
+        bounds.push_back({ bricks.pos(i), bricks.pos(i) + bricks.extent(i) });
+    brickGrid.build(bounds, BrickGrid::suggestCellSize(bounds));
+    scanHits.resize(bricks.paddedCount());
+    candidates.reserve(bricks.count());
+    killedBricks.reserve(bricks.count());
+}
+
+void GameWorld::spawnBall() {
+    Ball ball;
+    ball.radius = 10.0f;
+    ball.pos = glm::vec2(config.width / 2.0f, 200.0f);
+    ball.prevPos = ball.pos;
+    ball.vel = glm::vec2(200.0f, 200.0f);
+    balls.spawn(ball);
+}
+
+void GameWorld::step(float dt, const GameInput& input) {
+    if (gameOver || youWin) {
+        // Nothing moves any more; stop the renderer blending towards stale states.
+        paddle.prevPos = paddle.pos;
+        for (auto& ball : balls) ball.prevPos = ball.pos;
+        for (auto& pu : powerUps) pu.prevPos = pu.pos;
+        return;
+    }
+
+    killedBricks.clear();
+    updatePaddle(input);
+    updatePowerUps(dt);
+    updateBalls(dt);
+    collectPowerUps();
+    checkWin();
+}
+
+void GameWorld::updatePaddle(const GameInput& input) {
+    paddle.prevPos = paddle.pos;
+    paddle.pos.x = input.paddleX - paddle.size.x / 2.0f;
+    if (paddle.pos.x < 0) paddle.pos.x = 0;
+    if (paddle.pos.x + paddle.size.x > config.width) paddle.pos.x = config.width - paddle.size.x;
+}
+
+void GameWorld::updatePowerUps(float dt) {
+    PROFILE_ZONE("power-ups");
+    for (uint32_t i = 0; i < powerUps.slotCount(); ++i) {
+        if (!powerUps.alive(i)) continue;
+        PowerUp& pu = powerUps[i];
+        if (pu.active) {
+            pu.prevPos = pu.pos;
+            pu.pos += pu.vel * dt;
+            if (pu.pos.y < -pu.size.y) {
+                pu.active = false;
+            }
+        }
+        if (!pu.active) powerUps.despawnAt(i);
+    }
+}
+
+namespace {
+
+const float kSkin = 1e-3f;
+const size_t kScanCellRatio = 16;
+// Below this many balls the serial loop is cheaper than waking the workers.
+const size_t kParallelBalls = 32;
+const size_t kBallGrain = 8;
+
+enum HitKind { HIT_NONE, HIT_WALL, HIT_PADDLE, HIT_BRICK };
+
+}
+
+void GameWorld::hitBrick(int brick) {
+    if (!bricks.hit(brick)) return;
+    brickGrid.remove(brick);
+    killedBricks.push_back(brick);
+    score += config.brickPoints;
+    spawnPowerUp(brick);
+}
+
+void GameWorld::spawnPowerUp(int brick) {
+    uint8_t drop = bricks.drop[brick];
+    if (drop == BrickStore::kDropNever) return;
+    PowerUpType type;
+    if (drop != BrickStore::kDropRoll) {
+        type = (PowerUpType)(drop - BrickStore::kDropType);
+    }
+    else if (!config.level) {
+        if (rng.bounded(100) >= 30) return;
+        type = (PowerUpType)rng.bounded(2);
+    }
+    else {
+        const LevelFileHeader& h = config.level->header();
+        const LevelPowerUp* table = config.level->powerUps();
+        if (h.powerUpCount == 0 || rng.uniform() >= h.dropChance) return;
+        float total = 0.0f;
+        for (uint32_t i = 0; i < h.powerUpCount; ++i) total += table[i].weight;
+        float pick = rng.uniform() * total;
+        uint32_t i = 0;
+        while (i + 1 < h.powerUpCount && pick >= table[i].weight) pick -= table[i++].weight;
+        type = (PowerUpType)table[i].type;
+    }
+
+    PowerUp pu;
+    pu.pos = glm::vec2(bricks.pos(brick).x + bricks.extent(brick).x * 0.5f, bricks.pos(brick).y);
+    pu.prevPos = pu.pos;
+    pu.vel = glm::vec2(0.0f, -100.0f);
+    pu.size = glm::vec2(30.0f, 30.0f);
+    pu.type = type;
+    pu.active = true;
+    powerUps.spawn(pu);
+}
+
+// Moves one ball through a whole step, resolving every contact in time order:
+// sweep to the earliest wall, paddle or brick hit, respond, then carry on
+// with whatever is left of the motion. With `detect` set, brick hits are only
+// recorded there (and a brick is treated as gone for the rest of this ball's
+// motion once it has taken as many hits as it had left);
+// nothing shared is written, so several balls can be detected at once.
+void GameWorld::moveBall(Ball& ball, float dt, BallMove* detect, std::vector<int>& candidates,
+    std::vector<uint32_t>& scanHits)
+{
+    const float W = config.width, H = config.height;
+    const float r = ball.radius;
+
+    float remaining = 1.0f;
+    for (int bounce = 0; bounce < kMaxBounces && remaining > 0.0f; ++bounce) {
+        glm::vec2 d = ball.vel * (dt * remaining);
+        float bestT = 2.0f;
+        glm::vec2 bestN(0.0f);
+        HitKind kind = HIT_NONE;
+        int brick = -1;
+
+        // Walls: left, right and ceiling. The floor is open.
+        if (d.x < 0.0f) {
+            float t = std::max(0.0f, (r - ball.pos.x) / d.x);
+            if (t <= 1.0f && t < bestT) { bestT = t; bestN = glm::vec2(1, 0); kind = HIT_WALL; }
+        }
+        if (d.x > 0.0f) {
+            float t = std::max(0.0f, (W - r - ball.pos.x) / d.x);
+            if (t <= 1.0f && t < bestT) { bestT = t; bestN = glm::vec2(-1, 0); kind = HIT_WALL; }
+        }
+        if (d.y > 0.0f) {
+            float t = std::max(0.0f, (H - r - ball.pos.y) / d.y);
+            if (t <= 1.0f && t < bestT) { bestT = t; bestN = glm::vec2(0, -1); kind = HIT_WALL; }
+        }
+
+        float t;
+        glm::vec2 n;
+        if (sweepCircleAABB(ball.pos, d, r, paddle.pos, paddle.pos + paddle.size, t, n) && t < bestT) {
+            bestT = t; bestN = n; kind = HIT_PADDLE;
+        }
+
+        glm::vec2 end = ball.pos + d;
+        glm::vec2 lo = glm::min(ball.pos, end) - glm::vec2(r), hi = glm::max(ball.pos, end) + glm::vec2(r);
+        candidates.clear();
+        // Below the bricks, or where the rows have been cleared, there is
+        // nothing to search for.
+        bool bricksNear = bricks.liveRowsOverlap(lo.y, hi.y);
+        if (bricksNear && (size_t)brickGrid.cellsCovered(lo, hi) * kScanCellRatio > bricks.count()) {
+            // A very long move covers so many cells that one SIMD pass over all
+            // bricks, against a circle enclosing the swept path, is cheaper.
+            float reach = r + glm::length(d) * 0.5f;
+            size_t hits = circleOverlapBatch(bricks, 0, bricks.count(), (ball.pos + end) * 0.5f, reach, scanHits.data());
+            candidates.assign(scanHits.begin(), scanHits.begin() + hits);
+        }
+        else if (bricksNear) {
+            brickGrid.query(lo, hi, candidates);
+        }
+        for (int bi : candidates) {
+            if (detect && std::count(detect->hits, detect->hits + detect->hitCount, bi) >= bricks.hitPoints[bi])
+                continue;
+            glm::vec2 bMin = bricks.pos(bi);
+            if (sweepCircleAABB(ball.pos, d, r, bMin, bMin + bricks.extent(bi), t, n) && t < bestT) {
+                bestT = t; bestN = n; kind = HIT_BRICK; brick = bi;
+            }
+        }
+
+        if (kind == HIT_NONE) {
+            ball.pos = end;
+            break;
+        }
+
+        ball.pos += d * bestT + bestN * kSkin;
+        remaining *= 1.0f - bestT;
+
+        if (kind == HIT_WALL) {
+            if (bestN.x != 0.0f) ball.vel.x = -ball.vel.x;
+            else ball.vel.y = -ball.vel.y;
+        }
+        else if (kind == HIT_PADDLE) {
+            if (bestN.y > 0.0f) {
+                ball.vel.y = std::fabs(ball.vel.y);
+                float hitNorm = (ball.pos.x - (paddle.pos.x + paddle.size.x * 0.5f)) / (paddle.size.x * 0.5f);
+                ball.vel.x += hitNorm * 150.0f;
+            }
+            else {
+                ball.vel -= 2.0f * glm::dot(ball.vel, bestN) * bestN;
+            }
+        }
+        else {
+            if (detect) {
+                detect->hits[detect->hitCount] = brick;
+                detect->hitPoints[detect->hitCount++] = bricks.hitPoints[brick];
+            }
+            else {
+                hitBrick(brick);
+            }
+            if (std::fabs(bestN.x) > std::fabs(bestN.y)) ball.vel.x *= -1.0f;
+            else ball.vel.y *= -1.0f;
+        }
+    }
+}
+
+void GameWorld::detectBalls(size_t begin, size_t end, float dt) {
+    PROFILE_ZONE("ball detect");
+    static thread_local std::vector<int> localCandidates;
+    static thread_local std::vector<uint32_t> localHits;
+    if (localHits.size() < bricks.paddedCount()) localHits.resize(bricks.paddedCount());
+    for (size_t i = begin; i < end; ++i) {
+        if (!balls.alive((uint32_t)i)) continue;
+        BallMove& m = ballMoves[i];
+        m.ball = balls[(uint32_t)i];
+        m.ball.prevPos = m.ball.pos;
+        m.hitCount = 0;
+        moveBall(m.ball, dt, &m, localCandidates, localHits);
+    }
+}
+
+void GameWorld::updateBalls(float dt) {
+    PROFILE_ZONE("balls");
+    bool ballLost = false;
+    if (jobs && balls.size() >= kParallelBalls) {
+        // Detect every ball against the bricks as they stand, in parallel.
+        ballMoves.resize(balls.slotCount());
+        jobs->parallelFor(balls.slotCount(), kBallGrain, [&](size_t begin, size_t end) { detectBalls(begin, end, dt); });
+
+        // Resolve in ball order, exactly as the serial loop would. A detected
+        // path stays valid unless a brick it hit has since been hit by an
+        // earlier ball, which may have removed it; such a ball is re-run.
+        for (uint32_t i = 0; i < balls.slotCount(); ++i) {
+            if (!balls.alive(i)) continue;
+            Ball& ball = balls[i];
+            BallMove& m = ballMoves[i];
+            bool stale = false;
+            for (int k = 0; k < m.hitCount && !stale; ++k) stale = bricks.hitPoints[m.hits[k]] != m.hitPoints[k];
+            if (stale) {
+                ball.prevPos = ball.pos;
+                moveBall(ball, dt, nullptr, candidates, scanHits);
+            }
+            else {
+                ball = m.ball;
+                for (int k = 0; k < m.hitCount; ++k) hitBrick(m.hits[k]);
+            }
+            if (ball.pos.y - ball.radius < 0) {
+                ballLost = true;
+                break;
+            }
+        }
+    }
+    else {
+        for (auto& ball : balls) {
+            ball.prevPos = ball.pos;
+            moveBall(ball, dt, nullptr, candidates, scanHits);
+
+            if (ball.pos.y - ball.radius < 0) {
+                ballLost = true;
+                break;
+            }
+        }
+    }
+
+    if (ballLost) loseBalls();
+}
+
+void GameWorld::loseBalls() {
+    for (uint32_t i = 0; i < balls.slotCount(); ++i)
+        if (balls.alive(i) && balls[i].pos.y - balls[i].radius < 0) balls.despawnAt(i);
+
+    if (balls.empty()) {
+        lives--;
+        if (lives <= 0) {
+            gameOver = true;
+        }
+        else {
+            spawnBall();
+        }
+    }
+}
+
+void GameWorld::collectPowerUps() {
+    for (auto& pu : powerUps) {
+        if (!pu.active) continue;
+        if (pu.pos.x + pu.size.x > paddle.pos.x &&
+            pu.pos.x < paddle.pos.x + paddle.size.x &&
+            pu.pos.y + pu.size.y > paddle.pos.y &&
+            pu.pos.y < paddle.pos.y + paddle.size.y) {
+
+            if (pu.type == MULTIBALL) {
+                // Split the first three balls; copy them first so spawning into
+                // a free slot cannot feed a new ball back into the loop.
+                Ball sources[3];
+                int ballsToCreate = 0;
+                for (const auto& b : balls) {
+                    if (ballsToCreate == 3) break;
+                    sources[ballsToCreate++] = b;
+                }
+                for (int i = 0; i < ballsToCreate; i++) {
+                    const Ball& existingBall = sources[i];
+                    Ball newBall = existingBall;
+                    float baseAngle = std::atan2(existingBall.vel.y, existingBall.vel.x);
+                    float angleOffset = ((int)rng.bounded(90) - 45) * 3.14159f / 180.0f;
+                    float newAngle = baseAngle + angleOffset;
+                    float speed = glm::length(existingBall.vel);
+                    newBall.vel.x = std::cos(newAngle) * speed;
+                    newBall.vel.y = std::sin(newAngle) * speed;
+                    if (newBall.vel.y < 0) newBall.vel.y = -newBall.vel.y;
+                    newBall.prevPos = newBall.pos;
+                    balls.spawn(newBall);
+                }
+            }
+            else if (pu.type == EXTRALIFE) {
+                lives++;
+            }
+
+            pu.active = false;
+        }
+    }
+}
+
+void GameWorld::checkWin() {
+    if (bricks.liveCount() == 0) {
+        youWin = true;
+    }
+}
+
+namespace {
+
+struct Fnv1a {
+    uint64_t h = 14695981039346656037ull;
+
+    void bytes(const void* p, size_t n) {
+        const unsigned char* b = (const unsigned char*)p;
+        for (size_t i = 0; i < n; ++i) {
+            h ^= b[i];
+            h *= 1099511628211ull;
+        }
+    }
+    void f(float v) { uint32_t u; std::memcpy(&u, &v, 4); bytes(&u, 4); }
+    void i(int64_t v) { bytes(&v, 8); }
+    void v2(const glm::vec2& v) { f(v.x); f(v.y); }
+};
+
+}
+
+uint64_t GameWorld::stateHash() const {
+    Fnv1a h;
+    h.v2(paddle.pos);
+    h.v2(paddle.size);
+    h.i((int64_t)balls.size());
+    for (const auto& b : balls) {
+        h.v2(b.pos);
+        h.v2(b.vel);
+        h.f(b.radius);
+    }
+    h.i((int64_t)powerUps.size());
+    for (const auto& pu : powerUps) {
+        h.v2(pu.pos);
+        h.v2(pu.vel);
+        h.i(pu.type);
+        h.i(pu.active);
+    }
+    h.i(lives);
+    h.i(score);
+    h.i(gameOver);
+    h.i(youWin);
+    if (!bricks.laneMask.empty())
+        h.bytes(bricks.laneMask.data(), bricks.laneMask.size() * sizeof(uint16_t));
+    if (!bricks.hitPoints.empty())
+        h.bytes(bricks.hitPoints.data(), bricks.hitPoints.size());
+    h.i((int64_t)rng.state);
+    h.i((int64_t)rng.inc);
+    return h.h;
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "brick_grid.h"
+#include "brick_store.h"
+#include "job_system.h"
+#include "level.h"
+#include "pool.h"
+#include "rng.h"
+
+#include <glm.hpp>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Gameplay simulation with no window, GL or GLFW dependency. main() feeds it
+// input and draws whatever state it leaves behind; benchmarks step it headless.
+
+struct Ball {
+    glm::vec2 pos;
+    glm::vec2 prevPos;   // position at the start of the last step, for interpolation
+    glm::vec2 vel;
+    float radius;
+};
+
+struct Paddle {
+    glm::vec2 pos;
+    glm::vec2 prevPos;
+    glm::vec2 size;
+};
+
+enum PowerUpType {
+    MULTIBALL = 0,
+    EXTRALIFE = 1
+};
+
+struct PowerUp {
+    glm::vec2 pos;
+    glm::vec2 prevPos;
+    glm::vec2 vel;
+    glm::vec2 size;
+    PowerUpType type;
+    bool active;
+};
+
+struct GameInput {
+    float paddleX = 0.0f;   // desired paddle centre, in world units
+};
+
+struct WorldConfig {
+    float width = 800.0f;
+    float height = 600.0f;
+    int rows = 5;
+    int cols = 10;
+    int lives = 5;
+    int brickPoints = 10;
+    uint32_t seed = 1;   // drives power-up drops and multiball angles
+    uint32_t stream = 0;   // worlds sharing a seed but not a stream get independent randomness
+    int maxBalls = 256;
+    int maxPowerUps = 64;
+    // When set, bricks and the power-up table come from this level instead
+    // of the rows x cols wall, and every world built from it shares its arrays.
+    std::shared_ptr<const Level> level;
+};
+
+struct GameWorld {
+    WorldConfig config;
+
+    Paddle paddle;
+    Pool<Ball> balls;
+    Pool<PowerUp> powerUps;
+    BrickStore bricks;
+    int lives = 0;
+    int score = 0;
+    bool gameOver = false;
+    bool youWin = false;
+    std::vector<int> killedBricks;   // bricks destroyed during the last step
+    // When set and there are many balls, contacts are detected in parallel;
+    // results are identical to stepping on one thread.
+    JobSystem* jobs = nullptr;
+
+    explicit GameWorld(const WorldConfig& cfg = WorldConfig());
+
+    void reset();
+    void step(float dt, const GameInput& input);
+    // FNV-1a over everything that affects future steps; equal worlds hash equal.
+    uint64_t stateHash() const;
+
+private:
+    void buildBricks();
+    void spawnBall();
+    void updatePaddle(const GameInput& input);
+    void updatePowerUps(float dt);
+    // Outcome of moving one ball against the bricks as they were at the start
+    // of the ball phase, without touching any shared state.
+    static const int kMaxBounces = 16;   // contacts resolved per ball per step
+
+    struct BallMove {
+        Ball ball;
+        int hits[kMaxBounces];           // bricks hit, in order; at most one per bounce
+        uint8_t hitPoints[kMaxBounces];  // what each had left when detected
+        int hitCount;
+    };
+
+    void updateBalls(float dt);
+    void detectBalls(size_t begin, size_t end, float dt);
+    void loseBalls();
+    void moveBall(Ball& ball, float dt, BallMove* detect, std::vector<int>& candidates,
+        std::vector<uint32_t>& scanHits);
+    void hitBrick(int brick);
+    void spawnPowerUp(int brick);
+    void collectPowerUps();
+    void checkWin();
+
+    Pcg32 rng;
+    BrickGrid brickGrid;
+    std::vector<int> candidates;
+    std::vector<uint32_t> scanHits;
+    std::vector<BallMove> ballMoves;
+};
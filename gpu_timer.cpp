@@ -0,0 +1,45 @@
+#include "gpu_timer.h"
+#include "profiler.h"
+
+bool GpuTimer::init() {
+    enabled = false;
+    if (!ARK_PROFILE || !GLAD_GL_VERSION_3_3 || !glGenQueries || !glGetQueryObjectui64v) return false;
+    // Drivers without a GPU clock (some software rasterisers) report no counter bits.
+    GLint bits = 0;
+    glGetQueryiv(GL_TIME_ELAPSED, GL_QUERY_COUNTER_BITS, &bits);
+    if (bits == 0) return false;
+    glGenQueries(kFrames * kMaxPasses, &queries[0][0]);
+    enabled = glGetError() == GL_NO_ERROR;
+    return enabled;
+}
+
+void GpuTimer::beginFrame() {
+    if (!enabled) return;
+    frame = (frame + 1) % kFrames;
+    for (int i = 0; i < counts[frame]; ++i) {
+        GLuint ready = 0;
+        glGetQueryObjectuiv(queries[frame][i], GL_QUERY_RESULT_AVAILABLE, &ready);
+        if (!ready) {
+            resultsLate++;
+            continue;
+        }
+        GLuint64 nanos = 0;
+        glGetQueryObjectui64v(queries[frame][i], GL_QUERY_RESULT, &nanos);
+        profiler.recordGpu(names[frame][i], nanos);
+    }
+    counts[frame] = 0;
+}
+
+void GpuTimer::begin(const char* pass) {
+    if (!enabled || open || counts[frame] == kMaxPasses) return;
+    int i = counts[frame]++;
+    names[frame][i] = pass;
+    glBeginQuery(GL_TIME_ELAPSED, queries[frame][i]);
+    open = true;
+}
+
+void GpuTimer::end() {
+    if (!open) return;
+    glEndQuery(GL_TIME_ELAPSED);
+    open = false;
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "render_device.h"
+
+#include <glad.h>
+
+#include <cstdint>
+
+// GPU time per render pass from GL_TIME_ELAPSED queries. Each frame uses its
+// own set of queries from a ring of kFrames, and a set is only read back
+// when the ring comes round to it again, so results arrive kFrames - 1
+// frames late and the CPU never waits for them. They are handed to the
+// Profiler as zones named after the pass.
+//
+// Passes cannot nest. Without usable timer queries (or with ARK_PROFILE=0)
+// init() returns false and every call does nothing.
+class GpuTimer : public PassTimer {
+public:
+    static const int kFrames = 4;
+    static const int kMaxPasses = 16;
+
+    bool init();
+    bool available() const { return enabled; }
+
+    // Reports the results of the frame whose queries are about to be reused.
+    void beginFrame() override;
+    // `pass` names the profiler zone.
+    void begin(const char* pass) override;
+    void end() override;
+
+    int resultsLate = 0;   // results still pending when their queries were reused
+
+private:
+    bool enabled = false;
+    GLuint queries[kFrames][kMaxPasses] = {};
+    const char* names[kFrames][kMaxPasses] = {};
+    int counts[kFrames] = {};
+    int frame = 0;
+    bool open = false;
+};
@@ -0,0 +1,99 @@
+#include "job_system.h"
+#include "profiler.h"
+
+#include <algorithm>
+
+JobSystem::JobSystem(int threads) {
+    if (threads <= 0) threads = std::max(1, (int)std::thread::hardware_concurrency());
+    for (int i = 0; i < threads; ++i) queues.emplace_back(new Queue());
+    for (int i = 1; i < threads; ++i) workers.emplace_back(&JobSystem::workerMain, this, i);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(wakeM);
+        quit = true;
+    }
+    wakeCv.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+bool JobSystem::popOrSteal(int self, Task& out) {
+    {
+        Queue& q = *queues[self];
+        std::lock_guard<std::mutex> lock(q.m);
+        if (!q.tasks.empty()) {
+            out = q.tasks.back();
+            q.tasks.pop_back();
+            return true;
+        }
+    }
+    int n = (int)queues.size();
+    for (int k = 1; k < n; ++k) {
+        Queue& q = *queues[(self + k) % n];
+        std::lock_guard<std::mutex> lock(q.m);
+        if (!q.tasks.empty()) {
+            out = q.tasks.front();
+            q.tasks.pop_front();
+            stealCount.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::workerMain(int self) {
+    profiler.setThreadName("job worker " + std::to_string(self));
+    unsigned long long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(wakeM);
+            wakeCv.wait(lock, [&] { return quit || generation != seen; });
+            if (quit) return;
+            seen = generation;
+        }
+        Task t;
+        while (popOrSteal(self, t)) {
+            (*t.fn)(t.begin, t.end);
+            t.remaining->fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+}
+
+void JobSystem::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn) {
+    if (count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+    size_t chunks = (count + grain - 1) / grain;
+    if (chunks == 1 || queues.size() == 1) {
+        fn(0, count);
+        return;
+    }
+
+    // On the stack: the last fetch_sub on it is the last thing any task of
+    // this call does, and the loop below waits for exactly that.
+    std::atomic<size_t> remaining{ chunks };
+    // Contiguous runs per queue keep neighbouring chunks on one core until someone steals.
+    int n = (int)queues.size();
+    for (int w = 0; w < n; ++w) {
+        size_t c0 = chunks * w / n, c1 = chunks * (w + 1) / n;
+        std::lock_guard<std::mutex> lock(queues[w]->m);
+        for (size_t c = c0; c < c1; ++c)
+            queues[w]->tasks.push_back({ &fn, c * grain, std::min(count, (c + 1) * grain), &remaining });
+    }
+    {
+        std::lock_guard<std::mutex> lock(wakeM);
+        generation++;
+    }
+    wakeCv.notify_all();
+
+    Task t;
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (popOrSteal(0, t)) {
+            (*t.fn)(t.begin, t.end);
+            t.remaining->fetch_sub(1, std::memory_order_acq_rel);
+        }
+        else {
+            std::this_thread::yield();
+        }
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed pool of worker threads with one task deque each. An idle worker pops
+// from the back of its own deque and, when that is empty, steals from the
+// front of the others, so uneven chunks even out across cores.
+class JobSystem {
+public:
+    // 0 threads means one per hardware thread, counting the caller.
+    explicit JobSystem(int threads = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Including the calling thread, which helps while it waits.
+    int threadCount() const { return (int)queues.size(); }
+
+    // Calls fn(begin, end) over [0, count) in chunks of at most `grain` and
+    // returns once every chunk has run. Each call counts down its own chunks,
+    // so it may be made from inside a task or from several threads at once;
+    // a waiting caller runs whatever is queued, its own chunks or not.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& fn);
+
+    long long steals() const { return stealCount.load(std::memory_order_relaxed); }
+
+private:
+    struct Task {
+        const std::function<void(size_t, size_t)>* fn;
+        size_t begin, end;
+        std::atomic<size_t>* remaining;   // chunks of the parallelFor this came from
+    };
+    struct Queue {
+        std::mutex m;
+        std::deque<Task> tasks;
+    };
+
+    bool popOrSteal(int self, Task& out);
+    void workerMain(int self);
+
+    std::vector<std::unique_ptr<Queue>> queues;   // [0] belongs to the calling thread
+    std::vector<std::thread> workers;
+    std::atomic<long long> stealCount{ 0 };
+
+    std::mutex wakeM;
+    std::condition_variable wakeCv;
+    unsigned long long generation = 0;
+    bool quit = false;
+};
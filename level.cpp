@@ -0,0 +1,428 @@
+#include "level.h"
+#include "game_world.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+const char kMagic[4] = { 'A', 'R', 'K', 'L' };
+const size_t kSectionAlign = 64;
+
+uint64_t fnv1a(const uint8_t* p, size_t n) {
+    uint64_t h = 14695981039346656037ull;
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+size_t sectionBytes(const LevelFileHeader& h, int section) {
+    switch (section) {
+    case SEC_COLOR: return (size_t)h.paddedCount * sizeof(glm::vec4);
+    case SEC_ROW: return (size_t)h.paddedCount * sizeof(int32_t);
+    case SEC_HIT_POINTS: case SEC_DROP: return h.paddedCount;
+    case SEC_ROW_COUNTS: return (size_t)h.rowCount * sizeof(uint32_t);
+    case SEC_POWER_UPS: return (size_t)h.powerUpCount * sizeof(LevelPowerUp);
+    default: return (size_t)h.paddedCount * sizeof(float);
+    }
+}
+
+}
+
+Level::~Level() {
+    if (!mapping) return;
+#if defined(_WIN32)
+    UnmapViewOfFile(data);
+    CloseHandle((HANDLE)mapping);
+#else
+    munmap((void*)data, size);
+#endif
+}
+
+std::shared_ptr<const Level> Level::open(const std::string& path, std::string& error) {
+    std::shared_ptr<Level> level(new Level());
+    level->source = path;
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        error = "cannot open " + path;
+        return nullptr;
+    }
+    LARGE_INTEGER fileSize;
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (!mapping) {
+        error = "cannot map " + path;
+        return nullptr;
+    }
+    level->data = (const uint8_t*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (!level->data) {
+        CloseHandle(mapping);
+        error = "cannot map " + path;
+        return nullptr;
+    }
+    level->mapping = mapping;
+    level->size = (size_t)fileSize.QuadPart;
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        error = "cannot open " + path;
+        return nullptr;
+    }
+    struct stat st;
+    void* p = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size > 0)
+        p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        error = "cannot map " + path;
+        return nullptr;
+    }
+    level->data = (const uint8_t*)p;
+    level->mapping = p;
+    level->size = (size_t)st.st_size;
+#endif
+    if (!level->bind(error)) return nullptr;
+    return level;
+}
+
+std::shared_ptr<const Level> Level::fromBytes(std::vector<uint8_t> bytes, const std::string& path,
+    std::string& error)
+{
+    std::shared_ptr<Level> level(new Level());
+    level->source = path;
+    level->owned = std::move(bytes);
+    level->data = level->owned.data();
+    level->size = level->owned.size();
+    if (!level->bind(error)) return nullptr;
+    return level;
+}
+
+// Validates the header and points the views at the sections.
+bool Level::bind(std::string& error) {
+    if (size < sizeof(LevelFileHeader) || std::memcmp(data, kMagic, 4) != 0) {
+        error = "not a compiled level";
+        return false;
+    }
+    const LevelFileHeader& h = header();
+    if (h.version != kVersion) {
+        error = "level version " + std::to_string(h.version) + ", expected " + std::to_string(kVersion);
+        return false;
+    }
+    if (h.fileBytes != size || h.paddedCount % BrickStore::kBrickLanes != 0 || h.brickCount > h.paddedCount) {
+        error = "corrupt level header";
+        return false;
+    }
+    for (int s = 0; s < SEC_COUNT; ++s) {
+        uint64_t off = h.offsets[s];
+        if (off % kSectionAlign != 0 || off < sizeof(LevelFileHeader) || off > size || sectionBytes(h, s) > size - off) {
+            error = "level section out of range";
+            return false;
+        }
+    }
+
+    arrays.count = h.brickCount;
+    arrays.padded = h.paddedCount;
+    arrays.rows = (int)h.rowCount;
+    arrays.minX = (const float*)(data + h.offsets[SEC_MIN_X]);
+    arrays.minY = (const float*)(data + h.offsets[SEC_MIN_Y]);
+    arrays.maxX = (const float*)(data + h.offsets[SEC_MAX_X]);
+    arrays.maxY = (const float*)(data + h.offsets[SEC_MAX_Y]);
+    arrays.color = (const glm::vec4*)(data + h.offsets[SEC_COLOR]);
+    arrays.row = (const int32_t*)(data + h.offsets[SEC_ROW]);
+    arrays.hitPoints = data + h.offsets[SEC_HIT_POINTS];
+    arrays.drop = data + h.offsets[SEC_DROP];
+    arrays.rowCounts = (const uint32_t*)(data + h.offsets[SEC_ROW_COUNTS]);
+    table = (const LevelPowerUp*)(data + h.offsets[SEC_POWER_UPS]);
+    return true;
+}
+
+bool Level::verify(std::string& error) const {
+    const LevelFileHeader& h = header();
+    if (fnv1a(data + sizeof(LevelFileHeader), size - sizeof(LevelFileHeader)) != h.checksum) {
+        error = "level checksum mismatch";
+        return false;
+    }
+    std::vector<uint32_t> rowCounts(h.rowCount, 0);
+    for (size_t i = 0; i < arrays.count; ++i) {
+        uint8_t drop = arrays.drop[i];
+        bool dropOk = drop == BrickStore::kDropRoll || drop == BrickStore::kDropNever ||
+            drop - BrickStore::kDropType <= EXTRALIFE;
+        if (arrays.hitPoints[i] == 0 || !dropOk || arrays.row[i] < 0 || arrays.row[i] >= (int32_t)h.rowCount ||
+            !(arrays.minX[i] < arrays.maxX[i]) || !(arrays.minY[i] < arrays.maxY[i])) {
+            error = "bad brick " + std::to_string(i);
+            return false;
+        }
+        rowCounts[arrays.row[i]]++;
+    }
+    for (size_t i = arrays.count; i < arrays.padded; ++i) {
+        if (arrays.hitPoints[i] != 0) {
+            error = "live padding brick " + std::to_string(i);
+            return false;
+        }
+    }
+    if (!std::equal(rowCounts.begin(), rowCounts.end(), arrays.rowCounts)) {
+        error = "row counts do not match the bricks";
+        return false;
+    }
+    for (uint32_t i = 0; i < h.powerUpCount; ++i) {
+        if (table[i].type < 0 || table[i].type > EXTRALIFE || !(table[i].weight >= 0.0f)) {
+            error = "bad power-up table entry " + std::to_string(i);
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace {
+
+struct BrickKey {
+    glm::vec4 color = glm::vec4(1.0f);
+    int hp = 1;
+    uint8_t drop = BrickStore::kDropRoll;
+};
+
+struct SourceBrick {
+    glm::vec2 min, max;
+    glm::vec4 color;
+    int row, hp;
+    uint8_t drop;
+};
+
+bool parsePowerUp(const std::string& name, int& type) {
+    if (name == "multiball") type = MULTIBALL;
+    else if (name == "extralife") type = EXTRALIFE;
+    else return false;
+    return true;
+}
+
+bool parseColor(const std::string& hex, glm::vec4& color) {
+    if (hex.size() != 6 || hex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) return false;
+    unsigned long v = std::stoul(hex, nullptr, 16);
+    color = glm::vec4(((v >> 16) & 0xFF) / 255.0f, ((v >> 8) & 0xFF) / 255.0f, (v & 0xFF) / 255.0f, 1.0f);
+    return true;
+}
+
+template <typename T>
+void putSection(std::vector<uint8_t>& out, LevelFileHeader& h, int section, const std::vector<T>& v) {
+    out.resize((out.size() + kSectionAlign - 1) / kSectionAlign * kSectionAlign, 0);
+    h.offsets[section] = out.size();
+    const uint8_t* p = (const uint8_t*)v.data();
+    out.insert(out.end(), p, p + v.size() * sizeof(T));
+}
+
+}
+
+bool compileLevel(const std::string& text, std::vector<uint8_t>& out, std::string& error) {
+    glm::vec2 fieldSize(800.0f, 600.0f);
+    float dropChance = 0.3f;
+    std::vector<LevelPowerUp> table;
+    BrickKey keys[256];
+    bool keyDefined[256] = {};
+    bool haveGrid = false;
+    float gridLeft = 0.0f, gridTop = 0.0f, cellW = 0.0f, cellH = 0.0f, gapX = 0.0f, gapY = 0.0f;
+    int rows = 0;
+    std::vector<SourceBrick> bricks;
+
+    std::istringstream lines(text);
+    std::string line;
+    for (int lineNo = 1; std::getline(lines, line); ++lineNo) {
+        size_t hash = line.find('#');
+        if (hash != std::string::npos) line.erase(hash);
+        std::istringstream in(line);
+        std::string word;
+        if (!(in >> word)) continue;
+        auto fail = [&](const std::string& what) {
+            error = "line " + std::to_string(lineNo) + ": " + what;
+            return false;
+        };
+
+        if (word == "size") {
+            if (!(in >> fieldSize.x >> fieldSize.y) || fieldSize.x <= 0.0f || fieldSize.y <= 0.0f)
+                return fail("expected size <width> <height>");
+        }
+        else if (word == "drops") {
+            if (!(in >> dropChance) || dropChance < 0.0f || dropChance > 1.0f)
+                return fail("expected drops <chance between 0 and 1>");
+        }
+        else if (word == "powerup") {
+            std::string name;
+            LevelPowerUp entry;
+            if (!(in >> name >> entry.weight) || !parsePowerUp(name, entry.type) || entry.weight < 0.0f)
+                return fail("expected powerup <multiball|extralife> <weight>");
+            table.push_back(entry);
+        }
+        else if (word == "key") {
+            std::string ch, hex, extra;
+            BrickKey key;
+            if (!(in >> ch >> hex) || ch.size() != 1 || ch == "." || !parseColor(hex, key.color))
+                return fail("expected key <char> <rrggbb> [hp] [drop]");
+            while (in >> extra) {
+                int type;
+                if (extra.find_first_not_of("0123456789") == std::string::npos) {
+                    key.hp = std::atoi(extra.c_str());
+                    if (key.hp < 1 || key.hp > 255) return fail("hit points must be 1 to 255");
+                }
+                else if (extra == "roll") key.drop = BrickStore::kDropRoll;
+                else if (extra == "none") key.drop = BrickStore::kDropNever;
+                else if (parsePowerUp(extra, type)) key.drop = (uint8_t)(BrickStore::kDropType + type);
+                else return fail("unknown drop '" + extra + "'");
+            }
+            keys[(uint8_t)ch[0]] = key;
+            keyDefined[(uint8_t)ch[0]] = true;
+        }
+        else if (word == "grid") {
+            if (!(in >> gridLeft >> gridTop >> cellW >> cellH >> gapX >> gapY) || cellW <= 0.0f || cellH <= 0.0f)
+                return fail("expected grid <left> <top> <cellW> <cellH> <gapX> <gapY>");
+            haveGrid = true;
+        }
+        else if (word == "row") {
+            std::string cells;
+            if (!haveGrid) return fail("row before grid");
+            in >> cells;
+            float top = gridTop - rows * (cellH + gapY);
+            for (size_t c = 0; c < cells.size(); ++c) {
+                uint8_t ch = (uint8_t)cells[c];
+                if (ch == '.') continue;
+                if (!keyDefined[ch]) return fail(std::string("undefined key '") + (char)ch + "'");
+                const BrickKey& key = keys[ch];
+                glm::vec2 min(gridLeft + c * (cellW + gapX), top - cellH);
+                bricks.push_back({ min, min + glm::vec2(cellW, cellH), key.color, rows, key.hp, key.drop });
+            }
+            rows++;
+        }
+        else if (word == "brick") {
+            glm::vec2 pos, size;
+            std::string ch;
+            if (!(in >> pos.x >> pos.y >> size.x >> size.y >> ch) || ch.size() != 1 || size.x <= 0.0f || size.y <= 0.0f)
+                return fail("expected brick <x> <y> <w> <h> <key>");
+            if (!keyDefined[(uint8_t)ch[0]]) return fail("undefined key '" + ch + "'");
+            const BrickKey& key = keys[(uint8_t)ch[0]];
+            bricks.push_back({ pos, pos + size, key.color, std::max(rows - 1, 0), key.hp, key.drop });
+            rows = std::max(rows, 1);
+        }
+        else {
+            return fail("unknown keyword '" + word + "'");
+        }
+    }
+
+    for (size_t i = 0; i < bricks.size(); ++i) {
+        const SourceBrick& b = bricks[i];
+        if (b.min.x < 0.0f || b.min.y < 0.0f || b.max.x > fieldSize.x || b.max.y > fieldSize.y) {
+            error = "brick " + std::to_string(i) + " lies outside the play field";
+            return false;
+        }
+    }
+    if (table.empty()) table = { { MULTIBALL, 1.0f }, { EXTRALIFE, 1.0f } };
+
+    size_t n = bricks.size();
+    size_t padded = (n + BrickStore::kBrickLanes - 1) / BrickStore::kBrickLanes * BrickStore::kBrickLanes;
+    std::vector<float> minX(padded, 0.0f), minY(padded, 0.0f), maxX(padded, 0.0f), maxY(padded, 0.0f);
+    std::vector<glm::vec4> color(padded, glm::vec4(0.0f));
+    std::vector<int32_t> row(padded, 0);
+    std::vector<uint8_t> hitPoints(padded, 0), drop(padded, BrickStore::kDropNever);
+    std::vector<uint32_t> rowCounts(rows, 0);
+    for (size_t i = 0; i < n; ++i) {
+        const SourceBrick& b = bricks[i];
+        minX[i] = b.min.x; minY[i] = b.min.y;
+        maxX[i] = b.max.x; maxY[i] = b.max.y;
+        color[i] = b.color;
+        row[i] = b.row;
+        hitPoints[i] = (uint8_t)b.hp;
+        drop[i] = b.drop;
+        rowCounts[b.row]++;
+    }
+
+    LevelFileHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, kMagic, 4);
+    h.version = Level::kVersion;
+    h.brickCount = (uint32_t)n;
+    h.paddedCount = (uint32_t)padded;
+    h.rowCount = (uint32_t)rows;
+    h.powerUpCount = (uint32_t)table.size();
+    h.width = fieldSize.x;
+    h.height = fieldSize.y;
+    h.dropChance = dropChance;
+
+    out.assign(sizeof(LevelFileHeader), 0);
+    putSection(out, h, SEC_MIN_X, minX);
+    putSection(out, h, SEC_MIN_Y, minY);
+    putSection(out, h, SEC_MAX_X, maxX);
+    putSection(out, h, SEC_MAX_Y, maxY);
+    putSection(out, h, SEC_COLOR, color);
+    putSection(out, h, SEC_ROW, row);
+    putSection(out, h, SEC_HIT_POINTS, hitPoints);
+    putSection(out, h, SEC_DROP, drop);
+    putSection(out, h, SEC_ROW_COUNTS, rowCounts);
+    putSection(out, h, SEC_POWER_UPS, table);
+    out.resize((out.size() + kSectionAlign - 1) / kSectionAlign * kSectionAlign, 0);
+    h.fileBytes = out.size();
+    h.checksum = fnv1a(out.data() + sizeof(LevelFileHeader), out.size() - sizeof(LevelFileHeader));
+    std::memcpy(out.data(), &h, sizeof(h));
+    return true;
+}
+
+std::shared_ptr<const Level> loadLevel(const std::string& path, std::string& error) {
+    std::shared_ptr<const Level> level;
+    std::ifstream file(path, std::ios::binary);
+    char magic[4] = {};
+    if (!file.read(magic, 4) || std::memcmp(magic, kMagic, 4) == 0) {
+        level = Level::open(path, error);
+    }
+    else {
+        file.seekg(0);
+        std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        std::vector<uint8_t> bytes;
+        if (!compileLevel(text, bytes, error)) return nullptr;
+        level = Level::fromBytes(std::move(bytes), path, error);
+    }
+    if (level && !level->verify(error)) return nullptr;
+    return level;
+}
+
+int runLevelCompiler(const std::string& sourcePath, const std::string& outPath) {
+    std::ifstream file(sourcePath, std::ios::binary);
+    if (!file) {
+        std::printf("could not read level source '%s'\n", sourcePath.c_str());
+        return 1;
+    }
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::vector<uint8_t> bytes;
+    std::string error;
+    if (!compileLevel(text, bytes, error)) {
+        std::printf("%s: %s\n", sourcePath.c_str(), error.c_str());
+        return 1;
+    }
+    std::ofstream outFile(outPath, std::ios::binary);
+    outFile.write((const char*)bytes.data(), bytes.size());
+    if (!outFile) {
+        std::printf("could not write '%s'\n", outPath.c_str());
+        return 1;
+    }
+    const LevelFileHeader& h = *(const LevelFileHeader*)bytes.data();
+    std::printf("%s -> %s: %u bricks in %u rows, %u power-ups, %zu bytes\n", sourcePath.c_str(), outPath.c_str(),
+        h.brickCount, h.rowCount, h.powerUpCount, bytes.size());
+    return 0;
+}
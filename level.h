@@ -0,0 +1,104 @@
+#pragma once
+
+#include "brick_store.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Levels are written as text (see compileLevel) and shipped as a compiled
+// binary that is memory-mapped and used in place: the brick arrays in the
+// file are already padded and laid out the way BrickStore reads them, so
+// opening a level reads the header and nothing else.
+//
+// File layout, little-endian: LevelFileHeader, then one 64-byte aligned
+// section per LevelSection at the offsets the header gives.
+
+enum LevelSection {
+    SEC_MIN_X, SEC_MIN_Y, SEC_MAX_X, SEC_MAX_Y,   // float per padded brick
+    SEC_COLOR,        // vec4 per padded brick
+    SEC_ROW,          // int32 per padded brick
+    SEC_HIT_POINTS,   // uint8 per padded brick, 0 for padding
+    SEC_DROP,         // uint8 per padded brick, BrickStore::kDrop*
+    SEC_ROW_COUNTS,   // uint32 per row
+    SEC_POWER_UPS,    // LevelPowerUp per table entry
+    SEC_COUNT
+};
+
+struct LevelPowerUp {
+    int32_t type;   // PowerUpType
+    float weight;   // relative to the other entries
+};
+
+struct LevelFileHeader {
+    char magic[4];
+    uint32_t version;
+    uint64_t fileBytes;
+    uint64_t checksum;   // FNV-1a of every byte after the header
+    uint32_t brickCount, paddedCount, rowCount, powerUpCount;
+    float width, height;
+    float dropChance;    // chance a brick that rolls the table drops anything
+    uint32_t reserved;
+    uint64_t offsets[SEC_COUNT];
+};
+
+class Level {
+public:
+    static const uint32_t kVersion = 1;
+
+    // Maps a compiled level. Checks the header and that every section lies
+    // inside the file; the contents are not read (see verify()).
+    static std::shared_ptr<const Level> open(const std::string& path, std::string& error);
+    // Same, over compiled bytes held in memory; `path` is only reported back.
+    static std::shared_ptr<const Level> fromBytes(std::vector<uint8_t> bytes, const std::string& path,
+        std::string& error);
+
+    ~Level();
+    Level(const Level&) = delete;
+    Level& operator=(const Level&) = delete;
+
+    // Full check of the checksum and every brick; reads the whole file.
+    bool verify(std::string& error) const;
+
+    const LevelFileHeader& header() const { return *(const LevelFileHeader*)data; }
+    const BrickArrays& bricks() const { return arrays; }
+    const LevelPowerUp* powerUps() const { return table; }
+    const std::string& path() const { return source; }
+    size_t sizeBytes() const { return size; }
+    bool mapped() const { return mapping != nullptr; }
+
+private:
+    Level() {}
+    bool bind(std::string& error);
+
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    void* mapping = nullptr;     // platform handle, set while the file is mapped
+    std::vector<uint8_t> owned;  // fromBytes() storage
+    std::string source;
+    BrickArrays arrays;
+    const LevelPowerUp* table = nullptr;
+};
+
+// Compiles level source text. Lines are `keyword args`, `#` starts a comment:
+//
+//   size 800 600                      play field, in world units
+//   drops 0.3                         chance a brick rolling the table drops anything
+//   powerup multiball 1               power-up table entry and its relative weight
+//   key R ff4040 [hp] [drop]          brick type for grid cells; drop is roll (default),
+//                                     none, multiball or extralife
+//   grid 10 590 69 30 10 20           left, top, cell width, height, gap x, gap y
+//   row RRRR..RRRR                    next grid row down; '.' leaves a cell empty
+//   brick 300 200 200 30 R            a brick placed freely (x, y, w, h, key), in the last row
+//
+// On failure returns false with the line number in `error`.
+bool compileLevel(const std::string& text, std::vector<uint8_t>& out, std::string& error);
+
+// Opens a level for play: a compiled file is mapped, anything else is
+// compiled from source in memory. Either way the level is verified.
+std::shared_ptr<const Level> loadLevel(const std::string& path, std::string& error);
+
+// Command-line entry: compiles `sourcePath` into `outPath` and prints a summary.
+int runLevelCompiler(const std::string& sourcePath, const std::string& outPath);
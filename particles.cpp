@@ -0,0 +1,235 @@
+#include "particles.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define ARK_X86 1
+#include <immintrin.h>
+#endif
+
+void ParticleSoA::resize(size_t capacity) {
+    size_t padded = (capacity + kParticleLanes - 1) / kParticleLanes * kParticleLanes;
+    for (auto* v : { &posX, &posY, &velX, &velY, &life, &invMaxLife, &r, &g, &b })
+        v->assign(padded, 0.0f);
+}
+
+namespace {
+
+inline void moveParticle(ParticleSoA& p, size_t from, size_t to) {
+    p.posX[to] = p.posX[from]; p.posY[to] = p.posY[from];
+    p.velX[to] = p.velX[from]; p.velY[to] = p.velY[from];
+    p.life[to] = p.life[from]; p.invMaxLife[to] = p.invMaxLife[from];
+    p.r[to] = p.r[from]; p.g[to] = p.g[from]; p.b[to] = p.b[from];
+}
+
+inline void advanceParticle(ParticleSoA& p, size_t i, float dt, float dv) {
+    p.velY[i] += dv;
+    p.posX[i] += p.velX[i] * dt;
+    p.posY[i] += p.velY[i] * dt;
+    p.life[i] -= dt;
+}
+
+// Fills the hole at k from the tail. Particles from past the slice end have
+// not been integrated yet, so they are integrated as they come in.
+inline size_t fillHole(ParticleSoA& p, size_t k, size_t end, size_t n, float dt, float dv) {
+    while (n > k + 1) {
+        if (n - 1 >= end) advanceParticle(p, n - 1, dt, dv);
+        if (p.life[n - 1] > 0.0f) break;
+        n--;
+    }
+    moveParticle(p, --n, k);
+    return n;
+}
+
+}
+
+size_t integrateParticlesScalar(ParticleSoA& p, size_t n, float dt, float gravity) {
+    for (size_t i = 0; i < n; ++i) {
+        p.velY[i] += gravity * dt;
+        p.posX[i] += p.velX[i] * dt;
+        p.posY[i] += p.velY[i] * dt;
+        p.life[i] -= dt;
+    }
+    // Swap-remove: the cost follows the number of deaths, not the live count.
+    for (size_t i = 0; i < n; ++i) {
+        if (p.life[i] > 0.0f) continue;
+        while (n > i + 1 && p.life[n - 1] <= 0.0f) n--;
+        moveParticle(p, --n, i);
+    }
+    return n;
+}
+
+#ifdef ARK_X86
+
+namespace {
+
+inline unsigned lowestBit(uint32_t v) {
+#if defined(_MSC_VER)
+    unsigned long i;
+    _BitScanForward(&i, v);
+    return (unsigned)i;
+#else
+    return (unsigned)__builtin_ctz(v);
+#endif
+}
+
+}
+
+// SSE is part of every x86-64 target, so this needs no runtime dispatch.
+// Over the whole set it culls exactly like the scalar version, so both leave
+// the same order.
+size_t integrateParticleSlice(ParticleSoA& p, size_t begin, size_t end, size_t n, float dt, float gravity) {
+    const __m128 vdt = _mm_set1_ps(dt), dv = _mm_set1_ps(gravity * dt), zero = _mm_setzero_ps();
+    for (size_t i = begin; i < end; i += 4) {
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(&p.velY[i]), dv);
+        __m128 vx = _mm_loadu_ps(&p.velX[i]);
+        _mm_storeu_ps(&p.velY[i], vy);
+        _mm_storeu_ps(&p.posX[i], _mm_add_ps(_mm_loadu_ps(&p.posX[i]), _mm_mul_ps(vx, vdt)));
+        _mm_storeu_ps(&p.posY[i], _mm_add_ps(_mm_loadu_ps(&p.posY[i]), _mm_mul_ps(vy, vdt)));
+        _mm_storeu_ps(&p.life[i], _mm_sub_ps(_mm_loadu_ps(&p.life[i]), vdt));
+    }
+    for (size_t i = begin; i < end && i < n; i += 4) {
+        uint32_t dead = (uint32_t)_mm_movemask_ps(_mm_cmple_ps(_mm_loadu_ps(&p.life[i]), zero));
+        while (dead) {
+            size_t k = i + lowestBit(dead);
+            dead &= dead - 1;
+            if (k >= n) break;
+            n = fillHole(p, k, end, n, dt, gravity * dt);
+        }
+    }
+    return n;
+}
+
+const char* particleKernelIsa() {
+    return "sse";
+}
+
+#else
+
+size_t integrateParticleSlice(ParticleSoA& p, size_t begin, size_t end, size_t n, float dt, float gravity) {
+    for (size_t i = begin; i < end; ++i) advanceParticle(p, i, dt, gravity * dt);
+    for (size_t i = begin; i < end && i < n; ++i)
+        if (p.life[i] <= 0.0f) n = fillHole(p, i, end, n, dt, gravity * dt);
+    return n;
+}
+
+const char* particleKernelIsa() {
+    return "scalar";
+}
+
+#endif
+
+size_t integrateParticles(ParticleSoA& p, size_t n, float dt, float gravity) {
+    return integrateParticleSlice(p, 0, n, n, dt, gravity);
+}
+
+ParticleSystem::ParticleSystem(const ParticleConfig& cfg, uint64_t seed)
+    : config(cfg), limit(cfg.capacity), rng(seed)
+{
+    soa.resize(config.capacity);
+    bursts.resize(std::max<size_t>(1, config.burstQueue));
+}
+
+void ParticleSystem::clear() {
+    count = 0;
+    burstHead = burstCount = 0;
+}
+
+void ParticleSystem::emit(const glm::vec2& pos, const glm::vec4& color, int n, float speed, float lifeSeconds) {
+    if (n <= 0) return;
+    Burst& slot = bursts[(burstHead + burstCount) % bursts.size()];
+    if (burstCount == bursts.size()) {
+        // Full: the oldest queued burst is the one nobody will miss.
+        dropped += bursts[burstHead].count;
+        burstHead = (burstHead + 1) % bursts.size();
+        burstCount--;
+    }
+    slot.pos = pos;
+    slot.color = color;
+    slot.count = n;
+    slot.speed = speed;
+    slot.life = lifeSeconds;
+    burstCount++;
+}
+
+void ParticleSystem::spawn(const Burst& burst, int n) {
+    for (int k = 0; k < n; ++k) {
+        size_t i = count++;
+        glm::vec2 v = diskRand(rng, burst.speed) + glm::vec2(0.0f, burst.speed * 0.5f);
+        float life = burst.life * rng.range(0.5f, 1.0f);
+        soa.posX[i] = burst.pos.x;
+        soa.posY[i] = burst.pos.y;
+        soa.velX[i] = v.x;
+        soa.velY[i] = v.y;
+        soa.life[i] = life;
+        soa.invMaxLife[i] = 1.0f / life;
+        // Sparks: the brick colour pushed towards white.
+        float spark = rng.uniform() * 0.6f;
+        soa.r[i] = burst.color.x + (1.0f - burst.color.x) * spark;
+        soa.g[i] = burst.color.y + (1.0f - burst.color.y) * spark;
+        soa.b[i] = burst.color.z + (1.0f - burst.color.z) * spark;
+    }
+}
+
+void ParticleSystem::update(float dt) {
+    PROFILE_ZONE("particles");
+    typedef std::chrono::steady_clock Clock;
+    auto t0 = Clock::now();
+    auto elapsedMicros = [&] { return std::chrono::duration<double, std::micro>(Clock::now() - t0).count(); };
+
+    // Integrate a slice at a time and check the clock in between. Once the
+    // next slice and one spawn slice would no longer fit, the particles not
+    // reached yet are dropped; they are the tail, so that costs nothing. The
+    // reserves are running means over earlier frames, so no slice is taken
+    // blind and one preempted slice does not starve the frames after it.
+    const size_t kIntegrateSlice = 1024;
+    const int kSpawnSlice = 64;
+    auto track = [](double& mean, double sample) { mean = mean == 0.0 ? sample : mean * 0.9 + sample * 0.1; };
+    size_t done = 0;
+    for (double now = elapsedMicros(); done < count && now + sliceMicros + spawnMicros <= config.budgetMicros;) {
+        size_t end = std::min(count, done + kIntegrateSlice);
+        count = integrateParticleSlice(soa, done, end, count, dt, config.gravity);
+        double before = now;
+        now = elapsedMicros();
+        if (end - done == kIntegrateSlice) track(sliceMicros, now - before);
+        done = std::min(end, count);
+    }
+    // What got integrated is what fits; emission fills up to that and no more.
+    limit = done < count ? done : config.capacity;
+    dropped += count - done;
+    count = done;
+
+    // Bursts are spawned a slice at a time, and only while the slice about to
+    // go still fits; a burst cut short stays queued with what is left of it.
+    for (double now = elapsedMicros(); burstCount > 0 && now + spawnMicros < config.budgetMicros;) {
+        Burst& burst = bursts[burstHead];
+        int room = (int)(limit - std::min(count, limit));
+        if (room == 0) {
+            dropped += burst.count;
+            burst.count = 0;
+        }
+        int n = std::min(std::min(burst.count, room), kSpawnSlice);
+        spawn(burst, n);
+        burst.count -= n;
+        if (burst.count == 0) {
+            burstHead = (burstHead + 1) % bursts.size();
+            burstCount--;
+        }
+        double before = now;
+        now = elapsedMicros();
+        if (n == kSpawnSlice) track(spawnMicros, now - before);
+    }
+    lastMicros = elapsedMicros();
+}
+
+size_t ParticleSystem::writeInstances(SpriteInstance* out, const glm::vec4& uv) const {
+    const float s = config.size, half = s * 0.5f;
+    for (size_t i = 0; i < count; ++i) {
+        out[i].rect = glm::vec4(soa.posX[i] - half, soa.posY[i] - half, s, s);
+        out[i].color = glm::vec4(soa.r[i], soa.g[i], soa.b[i], std::min(1.0f, soa.life[i] * soa.invMaxLife[i]));
+        out[i].uv = uv;
+    }
+    return count;
+}
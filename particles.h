@@ -0,0 +1,90 @@
+#pragma once
+
+#include "rng.h"
+#include "sprite_batch.h"
+
+#include <glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Particle state as structure-of-arrays, padded by kParticleLanes so the
+// integrate kernel never needs a scalar tail. Live particles are packed at
+// the front; culling swaps the last one into each hole, so order is not kept.
+struct ParticleSoA {
+    static const size_t kParticleLanes = 8;
+
+    std::vector<float> posX, posY, velX, velY;
+    std::vector<float> life, invMaxLife;
+    std::vector<float> r, g, b;
+
+    void resize(size_t capacity);
+};
+
+// Integrates n particles by dt under gravity, drops the expired ones and
+// returns how many are left.
+size_t integrateParticles(ParticleSoA& p, size_t n, float dt, float gravity);
+size_t integrateParticlesScalar(ParticleSoA& p, size_t n, float dt, float gravity);
+// Integrates and culls the slice [begin, end) of n live particles and returns
+// the new live count. Holes are filled from the tail, and particles that come
+// from past `end` are integrated on the way in, so after slices up to `end`
+// the first min(end, n) particles have all moved exactly once. `begin` is a
+// multiple of kParticleLanes.
+size_t integrateParticleSlice(ParticleSoA& p, size_t begin, size_t end, size_t n, float dt, float gravity);
+const char* particleKernelIsa();
+
+struct ParticleConfig {
+    size_t capacity = 131072;
+    float gravity = -600.0f;
+    float size = 4.0f;
+    double budgetMicros = 1500.0;   // CPU time per update(), integrate and emission together
+    size_t burstQueue = 256;        // pending bursts kept; the oldest is overwritten when full
+};
+
+// Debris bursts for dying bricks. emit() only queues a burst in a fixed ring;
+// update() spends its time budget integrating the live particles first, a
+// slice at a time, and then spawning queued bursts while they fit. When the
+// budget runs out mid-integrate, the particles not reached are dropped and
+// emission only refills up to the count that did fit.
+class ParticleSystem {
+public:
+    explicit ParticleSystem(const ParticleConfig& cfg = ParticleConfig(), uint64_t seed = 1);
+
+    void emit(const glm::vec2& pos, const glm::vec4& color, int count, float speed = 220.0f, float lifeSeconds = 0.8f);
+    void update(float dt);
+    void clear();
+
+    // Writes one sprite instance per live particle, fading alpha with age.
+    size_t writeInstances(SpriteInstance* out, const glm::vec4& uv) const;
+
+    size_t liveCount() const { return count; }
+    // Live particles emission may fill up to: what the last update managed
+    // to integrate when it ran out of time, else the capacity.
+    size_t liveLimit() const { return limit; }
+    size_t droppedParticles() const { return dropped; }
+    double lastUpdateMicros() const { return lastMicros; }
+
+private:
+    struct Burst {
+        glm::vec2 pos;
+        glm::vec4 color;
+        int count;
+        float speed, life;
+    };
+
+    void spawn(const Burst& burst, int n);
+
+    ParticleConfig config;
+    ParticleSoA soa;
+    size_t count = 0;
+    size_t limit;
+    size_t dropped = 0;
+    double lastMicros = 0.0;
+    // Running means of what update() reserves time for, in microseconds.
+    double sliceMicros = 0.0, spawnMicros = 0.0;
+    Pcg32 rng;
+
+    std::vector<Burst> bursts;   // ring buffer
+    size_t burstHead = 0, burstCount = 0;
+};
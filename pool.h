@@ -0,0 +1,128 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Identifies one spawn of a pooled object. The generation changes every time
+// a slot is reused, so a handle to a despawned object stops resolving instead
+// of silently pointing at whatever took its place.
+struct PoolHandle {
+    uint32_t index = 0;
+    uint32_t generation = 0;   // 0 never refers to a live object
+
+    bool valid() const { return generation != 0; }
+};
+
+// Fixed-capacity object pool with a free list. Storage is allocated by
+// reserve() only, so spawning and despawning never touch the heap. Objects
+// stay at their slot for their whole life; iteration visits live slots in
+// slot order, which keeps simulations deterministic.
+template <typename T>
+class Pool {
+public:
+    explicit Pool(uint32_t capacity = 0) { reserve(capacity); }
+
+    // Drops every object. Only reallocates when the capacity changes.
+    void reserve(uint32_t capacity) {
+        if (capacity != items.size()) {
+            items.assign(capacity, T());
+            generations.assign(capacity, 0);
+            live.assign(capacity, 0);
+            freeList.reserve(capacity);
+        }
+        clear();
+    }
+
+    void clear() {
+        for (uint32_t i = 0; i < used; ++i) {
+            if (live[i]) generations[i]++;
+            live[i] = 0;
+        }
+        freeList.clear();
+        used = 0;
+        count = 0;
+    }
+
+    // Returns an invalid handle when the pool is full.
+    PoolHandle spawn(const T& value) {
+        uint32_t i;
+        if (!freeList.empty()) {
+            i = freeList.back();
+            freeList.pop_back();
+        }
+        else if (used < items.size()) {
+            i = used++;
+        }
+        else {
+            return PoolHandle();
+        }
+        items[i] = value;
+        live[i] = 1;
+        if (++generations[i] == 0) generations[i] = 1;
+        count++;
+        return PoolHandle{ i, generations[i] };
+    }
+
+    bool despawn(PoolHandle h) {
+        if (!get(h)) return false;
+        despawnAt(h.index);
+        return true;
+    }
+
+    void despawnAt(uint32_t i) {
+        if (i >= used || !live[i]) return;
+        live[i] = 0;
+        generations[i]++;
+        freeList.push_back(i);
+        count--;
+    }
+
+    T* get(PoolHandle h) {
+        if (h.index >= used || !live[h.index] || generations[h.index] != h.generation) return nullptr;
+        return &items[h.index];
+    }
+    const T* get(PoolHandle h) const { return const_cast<Pool*>(this)->get(h); }
+
+    PoolHandle handleAt(uint32_t i) const { return live[i] ? PoolHandle{ i, generations[i] } : PoolHandle(); }
+
+    uint32_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool full() const { return count == items.size(); }
+    uint32_t capacity() const { return (uint32_t)items.size(); }
+
+    // Slot-level access: slots [0, slotCount()) may be live or free.
+    uint32_t slotCount() const { return used; }
+    bool alive(uint32_t i) const { return live[i] != 0; }
+    T& operator[](uint32_t i) { return items[i]; }
+    const T& operator[](uint32_t i) const { return items[i]; }
+
+    template <typename P, typename V>
+    class Iter {
+    public:
+        Iter(P* pool, uint32_t i) : pool(pool), i(i) { skip(); }
+        V& operator*() const { return (*pool)[i]; }
+        V* operator->() const { return &(*pool)[i]; }
+        Iter& operator++() { ++i; skip(); return *this; }
+        bool operator!=(const Iter& o) const { return i != o.i; }
+        bool operator==(const Iter& o) const { return i == o.i; }
+
+    private:
+        void skip() { while (i < pool->slotCount() && !pool->alive(i)) ++i; }
+        P* pool;
+        uint32_t i;
+    };
+
+    Iter<Pool, T> begin() { return Iter<Pool, T>(this, 0); }
+    Iter<Pool, T> end() { return Iter<Pool, T>(this, used); }
+    Iter<const Pool, const T> begin() const { return Iter<const Pool, const T>(this, 0); }
+    Iter<const Pool, const T> end() const { return Iter<const Pool, const T>(this, used); }
+
+private:
+    std::vector<T> items;
+    std::vector<uint32_t> generations;
+    std::vector<uint8_t> live;
+    std::vector<uint32_t> freeList;
+    uint32_t used = 0;    // slots ever handed out since the last clear
+    uint32_t count = 0;
+};
@@ -0,0 +1,193 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+Profiler profiler;
+
+namespace {
+
+thread_local ProfileThreadBuffer* localBuffer = nullptr;
+thread_local std::string localName;
+
+}
+
+float ZoneStats::last() const {
+    return frames ? micros[(next + kWindow - 1) % kWindow] : 0.0f;
+}
+
+float ZoneStats::mean() const {
+    if (!frames) return 0.0f;
+    float sum = 0.0f;
+    for (int i = 0; i < frames; ++i) sum += micros[i];
+    return sum / frames;
+}
+
+float ZoneStats::max() const {
+    float m = 0.0f;
+    for (int i = 0; i < frames; ++i) m = std::max(m, micros[i]);
+    return m;
+}
+
+float ZoneStats::percentile(float p) const {
+    if (!frames) return 0.0f;
+    float sorted[kWindow];
+    std::copy(micros, micros + frames, sorted);
+    int k = std::min(frames - 1, (int)(p * frames));
+    std::nth_element(sorted, sorted + k, sorted + frames);
+    return sorted[k];
+}
+
+int ZoneStats::bin(float us) {
+    if (us < 1.0f) return 0;
+    return std::min(kBins - 1, 1 + (int)std::log2(us));
+}
+
+ProfileThreadBuffer* Profiler::threadBuffer() {
+    if (!localBuffer) {
+        std::lock_guard<std::mutex> lock(registryM);
+        int n = bufferCount.load(std::memory_order_relaxed);
+        if (n == kMaxThreads) return nullptr;
+        buffers[n].reset(new ProfileThreadBuffer());
+        localBuffer = buffers[n].get();
+        localBuffer->id = n + 1;
+        if (!localName.empty()) localBuffer->name = localName;
+        else localBuffer->name = n == 0 ? "main" : "thread " + std::to_string(n + 1);
+        bufferCount.store(n + 1, std::memory_order_release);
+    }
+    return localBuffer;
+}
+
+void Profiler::record(const char* name, uint64_t start, uint64_t end) {
+    ProfileThreadBuffer* buffer = threadBuffer();
+    if (!buffer) return;
+    ProfileThreadBuffer& b = *buffer;
+    uint32_t head = b.head.load(std::memory_order_relaxed);
+    if (head - b.tail.load(std::memory_order_acquire) >= ProfileThreadBuffer::kCapacity) {
+        b.dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    b.events[head % ProfileThreadBuffer::kCapacity] = { name, start, end };
+    b.head.store(head + 1, std::memory_order_release);
+}
+
+void Profiler::setThreadName(const std::string& name) {
+    localName = name;
+    if (!localBuffer) return;
+    std::lock_guard<std::mutex> lock(registryM);
+    localBuffer->name = name;
+}
+
+void Profiler::recordGpu(const char* name, uint64_t nanos) {
+    gpuEvents.push_back({ name, 0, nanos });
+}
+
+ZoneStats& Profiler::statsFor(const char* name) {
+    // The same literal may have a different address in another translation unit.
+    for (auto& s : stats)
+        if (s.name == name || std::strcmp(s.name, name) == 0) return s;
+    stats.emplace_back();
+    stats.back().name = name;
+    frameMicros.push_back(0.0f);
+    frameCalls.push_back(0);
+    return stats.back();
+}
+
+void Profiler::endFrame() {
+    std::fill(frameMicros.begin(), frameMicros.end(), 0.0f);
+    std::fill(frameCalls.begin(), frameCalls.end(), 0);
+
+    int threads = bufferCount.load(std::memory_order_acquire);
+    for (int t = 0; t < threads; ++t) {
+        ProfileThreadBuffer& b = *buffers[t];
+        uint32_t tail = b.tail.load(std::memory_order_relaxed);
+        uint32_t head = b.head.load(std::memory_order_acquire);
+        for (; tail != head; ++tail) {
+            const ProfileEvent& e = b.events[tail % ProfileThreadBuffer::kCapacity];
+            size_t z = &statsFor(e.name) - stats.data();
+            frameMicros[z] += (e.end - e.start) * 1e-3f;
+            frameCalls[z]++;
+            // Events still buffered from before the trace started are left out.
+            if (traceFramesLeft > 0 && e.start >= traceOrigin) trace.push_back({ e, b.id });
+        }
+        b.tail.store(tail, std::memory_order_release);
+    }
+    for (const auto& e : gpuEvents) {
+        size_t z = &statsFor(e.name) - stats.data();
+        frameMicros[z] += e.end * 1e-3f;
+        frameCalls[z]++;
+    }
+    gpuEvents.clear();
+
+    // Zones that did not run this frame still advance, with a zero.
+    for (size_t z = 0; z < stats.size(); ++z) {
+        ZoneStats& s = stats[z];
+        if (s.frames == ZoneStats::kWindow) s.bins[ZoneStats::bin(s.micros[s.next])]--;
+        else s.frames++;
+        s.micros[s.next] = frameMicros[z];
+        s.bins[ZoneStats::bin(frameMicros[z])]++;
+        s.next = (s.next + 1) % ZoneStats::kWindow;
+        s.lastCalls = frameCalls[z];
+    }
+    // Keep the order stable between frames unless the ranking really changes.
+    for (size_t z = 1; z < stats.size(); ++z) {
+        for (size_t k = z; k > 0 && stats[k - 1].mean() < stats[k].mean(); --k) {
+            std::swap(stats[k - 1], stats[k]);
+            std::swap(frameMicros[k - 1], frameMicros[k]);
+            std::swap(frameCalls[k - 1], frameCalls[k]);
+        }
+    }
+    frames++;
+
+    if (traceFramesLeft > 0 && --traceFramesLeft == 0) {
+        if (writeTrace(tracePath))
+            std::printf("Trace of %zu zones written to %s\n", trace.size(), tracePath.c_str());
+        else
+            std::printf("Failed to write trace: %s\n", tracePath.c_str());
+        trace.clear();
+        trace.shrink_to_fit();
+    }
+}
+
+void Profiler::startTrace(const std::string& path, int frameCount) {
+    tracePath = path;
+    traceFramesLeft = std::max(1, frameCount);
+    traceOrigin = now();
+    trace.clear();
+}
+
+bool Profiler::writeTrace(const std::string& path) const {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    std::fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    {
+        std::lock_guard<std::mutex> lock(registryM);
+        for (int t = 0; t < bufferCount.load(); ++t)
+            std::fprintf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}},\n",
+                buffers[t]->id, buffers[t]->name.c_str());
+    }
+    bool first = true;
+    for (const auto& t : trace) {
+        std::fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+            first ? "" : ",\n", t.event.name, t.thread,
+            (t.event.start - traceOrigin) * 1e-3, (t.event.end - t.event.start) * 1e-3);
+        first = false;
+    }
+    std::fprintf(f, "\n]}\n");
+    return std::fclose(f) == 0;
+}
+
+const ZoneStats* Profiler::zone(const char* name) const {
+    for (const auto& s : stats)
+        if (s.name == name || std::strcmp(s.name, name) == 0) return &s;
+    return nullptr;
+}
+
+uint64_t Profiler::droppedEvents() const {
+    std::lock_guard<std::mutex> lock(registryM);
+    uint64_t n = 0;
+    for (int t = 0; t < bufferCount.load(); ++t) n += buffers[t]->dropped.load(std::memory_order_relaxed);
+    return n;
+}
@@ -0,0 +1,157 @@
+#pragma once
+
+// Build with ARK_PROFILE=0 to compile every PROFILE_ZONE out. The Profiler
+// itself stays, so callers need no #ifs; it just never sees an event. When
+// compiled in, zones cost a relaxed load until the Profiler is enabled, so
+// headless runs that never enable it keep their full speed.
+#ifndef ARK_PROFILE
+#define ARK_PROFILE 1
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One closed zone. Names are string literals, kept by pointer.
+struct ProfileEvent {
+    const char* name;
+    uint64_t start, end;   // Profiler::now()
+};
+
+// A zone's cost over the last kWindow frames: the total time spent in it per
+// frame (summed over threads) and a histogram of those totals in power-of-two
+// microsecond bins, [0, 1), [1, 2), [2, 4) ... with the last bin open-ended.
+struct ZoneStats {
+    static const int kWindow = 120;
+    static const int kBins = 16;
+
+    const char* name = nullptr;
+    float micros[kWindow] = {};
+    int bins[kBins] = {};
+    int frames = 0;       // filled entries of micros, at most kWindow
+    int next = 0;         // ring position of the next frame
+    int lastCalls = 0;
+
+    float last() const;
+    float mean() const;
+    float max() const;
+    float percentile(float p) const;
+    static int bin(float micros);
+};
+
+// Events recorded by one thread. Only that thread writes and only the
+// Profiler (on the main thread) reads, so a head/tail pair is all the
+// synchronisation needed; a full buffer drops events instead of waiting.
+struct ProfileThreadBuffer {
+    static const uint32_t kCapacity = 1 << 14;
+
+    ProfileEvent events[kCapacity];
+    std::atomic<uint32_t> head{ 0 };   // written by the owner
+    std::atomic<uint32_t> tail{ 0 };   // written by the reader
+    std::atomic<uint64_t> dropped{ 0 };
+    int id = 0;
+    std::string name;
+};
+
+class Profiler {
+public:
+    // Threads past this many record nothing.
+    static const int kMaxThreads = 64;
+
+    void enable(bool on) { active.store(on, std::memory_order_relaxed); }
+    bool enabled() const { return active.load(std::memory_order_relaxed); }
+
+    static uint64_t now() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Appends to the calling thread's buffer, registering it on first use.
+    void record(const char* name, uint64_t start, uint64_t end);
+    // Names the calling thread in traces. Does not register it.
+    void setThreadName(const std::string& name);
+
+    // Main thread: GPU time measured for a pass (see GpuTimer), counted
+    // in the stats of the frame it is reported in. Not traced.
+    void recordGpu(const char* name, uint64_t nanos);
+
+    // Main thread, once per frame: moves every thread's events into the zone
+    // stats and, while a trace is running, into the trace.
+    void endFrame();
+
+    // Records the next `frames` frames and writes them to `path` as Chrome
+    // trace_event JSON (chrome://tracing, Perfetto).
+    void startTrace(const std::string& path, int frames);
+    bool tracing() const { return traceFramesLeft > 0; }
+    bool writeTrace(const std::string& path) const;
+
+    // Sorted by mean cost, most expensive first.
+    const std::vector<ZoneStats>& zones() const { return stats; }
+    // Valid until the next endFrame().
+    const ZoneStats* zone(const char* name) const;
+    uint64_t droppedEvents() const;
+    int frameCount() const { return frames; }
+
+private:
+    ProfileThreadBuffer* threadBuffer();
+    ZoneStats& statsFor(const char* name);
+
+    // Appended under registryM and published through bufferCount, so
+    // endFrame() can walk the registered buffers without the lock.
+    std::atomic<bool> active{ false };
+    mutable std::mutex registryM;
+    std::unique_ptr<ProfileThreadBuffer> buffers[kMaxThreads];
+    std::atomic<int> bufferCount{ 0 };
+
+    std::vector<ZoneStats> stats;
+    std::vector<float> frameMicros;   // per stats entry, this frame
+    std::vector<int> frameCalls;
+    std::vector<ProfileEvent> gpuEvents;
+    int frames = 0;
+
+    struct TraceEvent {
+        ProfileEvent event;
+        int thread;
+    };
+    std::vector<TraceEvent> trace;
+    std::string tracePath;
+    int traceFramesLeft = 0;
+    uint64_t traceOrigin = 0;
+};
+
+extern Profiler profiler;
+
+#if ARK_PROFILE
+
+// Times the enclosing scope.
+class ProfileZone {
+public:
+    explicit ProfileZone(const char* zoneName) : name(profiler.enabled() ? zoneName : nullptr) {
+        if (name) start = Profiler::now();
+    }
+    ~ProfileZone() {
+        if (name) profiler.record(name, start, Profiler::now());
+    }
+
+    ProfileZone(const ProfileZone&) = delete;
+    ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+    const char* name;
+    uint64_t start = 0;
+};
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone_, __LINE__)(name)
+
+#else
+
+#define PROFILE_ZONE(name) ((void)0)
+
+#endif
@@ -0,0 +1,54 @@
+#include "rect_batch.h"
+#include "sprite_batch.h"
+
+#include <cstddef>
+
+bool RectBatch::init(RenderDevice& dev, GLuint prog, GLuint rectVAO, int cap, int flushesPerFrame) {
+    device = &dev;
+    program = prog;
+    VAO = rectVAO;
+    capacity = cap;
+    loc_projection = device->uniformLocation(program, "projection");
+    pending.reserve(capacity);
+
+    if (!stream.init(*device, (size_t)capacity * sizeof(RectInstance) * flushesPerFrame)) return false;
+    device->bindVertexArray(VAO);
+    device->enableVertexAttribArray(1);
+    device->vertexAttribDivisor(1, 1);
+    device->enableVertexAttribArray(2);
+    device->vertexAttribDivisor(2, 1);
+    device->bindVertexArray(0);
+    return true;
+}
+
+void RectBatch::begin() {
+    pending.clear();
+    stream.beginFrame();
+}
+
+void RectBatch::add(float x, float y, float w, float h, const glm::vec4& color) {
+    if ((int)pending.size() == capacity) return;
+    RectInstance inst;
+    inst.rect = glm::vec4(x, y, w, h);
+    inst.color = color;
+    pending.push_back(inst);
+}
+
+void RectBatch::flush(const glm::mat4& proj) {
+    if (pending.empty()) return;
+
+    size_t offset = stream.write(pending.data(), pending.size() * sizeof(RectInstance));
+    GLsizei stride = sizeof(RectInstance);
+    device->bindVertexArray(VAO);
+    device->vertexAttribPointer(1, 4, stride, offset + offsetof(RectInstance, rect));
+    device->vertexAttribPointer(2, 4, stride, offset + offsetof(RectInstance, color));
+
+    device->useProgram(program);
+    device->uniformMatrix4(loc_projection, proj);
+    device->drawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)pending.size());
+
+    renderStats.drawCalls++;
+    renderStats.uniformUploads++;
+    renderStats.instances += (int)pending.size();
+    pending.clear();
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "stream_buffer.h"
+
+#include <glad.h>
+#include <glm.hpp>
+
+#include <vector>
+
+struct RectInstance {
+    glm::vec4 rect;   // x, y, w, h
+    glm::vec4 color;
+};
+
+// Untextured rectangles (overlays, stroke text) gathered over a frame and
+// drawn with one instanced call per flush. Like SpriteBatch, the stream
+// moves to a new chunk once per frame, in begin().
+class RectBatch {
+public:
+    // A stream chunk holds `flushesPerFrame` full flushes; a frame that flushes
+    // more just moves on to the next chunk.
+    bool init(RenderDevice& device, GLuint program, GLuint rectVAO, int capacity, int flushesPerFrame = 2);
+    void begin();
+    void add(float x, float y, float w, float h, const glm::vec4& color);
+    void flush(const glm::mat4& proj);
+
+private:
+    RenderDevice* device = nullptr;
+    GLuint program = 0;
+    GLuint VAO = 0;
+    StreamBuffer stream;
+    GLint loc_projection = -1;
+    int capacity = 0;
+    std::vector<RectInstance> pending;
+};
@@ -0,0 +1,289 @@
+#include "render_device.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+const char* kOpNames[OP_COUNT] = {
+    "createBuffer", "bindBuffer", "bufferData", "bufferSubData", "bufferStorage",
+    "mapBufferRange", "unmapBuffer",
+    "fence", "waitFence", "deleteFence",
+    "bindVertexArray", "enableVertexAttribArray", "vertexAttribPointer", "vertexAttribDivisor",
+    "useProgram", "uniformLocation", "uniformMatrix4", "uniform1i",
+    "activeTexture", "bindTexture",
+    "setBlend", "blendFuncSeparate",
+    "clear", "drawArraysInstanced",
+};
+
+uint64_t fnv1a(const void* data, size_t bytes) {
+    const unsigned char* p = (const unsigned char*)data;
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < bytes; ++i) h = (h ^ p[i]) * 1099511628211ull;
+    return h;
+}
+
+}
+
+const char* renderOpName(RenderOp op) {
+    return op >= 0 && op < OP_COUNT ? kOpNames[op] : "?";
+}
+
+long long DeviceCounters::total() const {
+    long long n = 0;
+    for (long long c : calls) n += c;
+    return n;
+}
+
+void NullRenderDevice::note(RenderOp op, uint64_t, uint64_t, uint64_t, uint64_t) {
+    counters.calls[op]++;
+}
+
+GLuint NullRenderDevice::createBuffer() {
+    note(OP_CREATE_BUFFER, nextName);
+    return nextName++;
+}
+
+void NullRenderDevice::bindBuffer(GLenum target, GLuint buffer) {
+    if (!state.setBuffer(target, buffer)) counters.redundant++;
+    buffers[target] = buffer;
+    note(OP_BIND_BUFFER, target, buffer);
+}
+
+void NullRenderDevice::bufferData(GLenum target, size_t bytes, const void* data, GLenum usage) {
+    if (data) counters.bytes += bytes;
+    note(OP_BUFFER_DATA, target, bytes, data != nullptr, usage);
+}
+
+void NullRenderDevice::bufferSubData(GLenum target, size_t offset, size_t bytes, const void*) {
+    counters.bytes += bytes;
+    note(OP_BUFFER_SUB_DATA, target, offset, bytes);
+}
+
+void* NullRenderDevice::bufferStoragePersistent(GLenum target, size_t bytes) {
+    if (!persistent) return nullptr;
+    note(OP_BUFFER_STORAGE, target, bytes);
+    std::vector<unsigned char>& s = storage[buffers[target]];
+    s.assign(bytes, 0);
+    return s.data();
+}
+
+void* NullRenderDevice::mapBufferRange(GLenum target, size_t offset, size_t bytes, GLbitfield access) {
+    counters.bytes += bytes;
+    note(OP_MAP_BUFFER, target, offset, bytes, access);
+    if (scratch.size() < bytes) scratch.resize(bytes);
+    return scratch.data();
+}
+
+void NullRenderDevice::unmapBuffer(GLenum target) {
+    note(OP_UNMAP_BUFFER, target);
+}
+
+GLsync NullRenderDevice::fence() {
+    note(OP_FENCE, nextName);
+    return (GLsync)(uintptr_t)nextName++;
+}
+
+bool NullRenderDevice::waitFence(GLsync fence, uint64_t timeoutNanos) {
+    note(OP_WAIT_FENCE, (uintptr_t)fence, timeoutNanos);
+    return true;
+}
+
+void NullRenderDevice::deleteFence(GLsync fence) {
+    note(OP_DELETE_FENCE, (uintptr_t)fence);
+}
+
+void NullRenderDevice::bindVertexArray(GLuint array) {
+    if (!state.setVertexArray(array)) counters.redundant++;
+    note(OP_BIND_VERTEX_ARRAY, array);
+}
+
+void NullRenderDevice::enableVertexAttribArray(GLuint index) {
+    if (!state.enableAttrib(index)) counters.redundant++;
+    note(OP_ENABLE_ATTRIB, index);
+}
+
+void NullRenderDevice::vertexAttribPointer(GLuint index, GLint components, GLsizei stride, size_t offset) {
+    if (!state.setAttribPointer(index, components, stride, offset)) counters.redundant++;
+    note(OP_ATTRIB_POINTER, index, components, stride, offset);
+}
+
+void NullRenderDevice::vertexAttribDivisor(GLuint index, GLuint divisor) {
+    if (!state.setAttribDivisor(index, divisor)) counters.redundant++;
+    note(OP_ATTRIB_DIVISOR, index, divisor);
+}
+
+void NullRenderDevice::useProgram(GLuint p) {
+    if (!state.setProgram(p)) counters.redundant++;
+    note(OP_USE_PROGRAM, p);
+}
+
+GLint NullRenderDevice::uniformLocation(GLuint p, const char* name) {
+    GLint location = (GLint)(fnv1a(name, std::strlen(name)) & 0x7fff);
+    note(OP_UNIFORM_LOCATION, p, location);
+    return location;
+}
+
+void NullRenderDevice::uniformMatrix4(GLint location, const glm::mat4& m) {
+    if (!state.setUniform(location, m)) counters.redundant++;
+    note(OP_UNIFORM_MATRIX, location, fnv1a(&m[0][0], sizeof(float) * 16));
+}
+
+void NullRenderDevice::uniform1i(GLint location, GLint value) {
+    if (!state.setUniform(location, value)) counters.redundant++;
+    note(OP_UNIFORM_INT, location, value);
+}
+
+void NullRenderDevice::activeTexture(GLenum texUnit) {
+    if (!state.setActiveTexture(texUnit)) counters.redundant++;
+    note(OP_ACTIVE_TEXTURE, texUnit);
+}
+
+void NullRenderDevice::bindTexture(GLenum target, GLuint texture) {
+    if (!state.setTexture(target, texture)) counters.redundant++;
+    note(OP_BIND_TEXTURE, target, texture);
+}
+
+void NullRenderDevice::setBlend(bool enabled) {
+    if (!state.setBlend(enabled)) counters.redundant++;
+    note(OP_BLEND_ENABLE, enabled);
+}
+
+void NullRenderDevice::blendFuncSeparate(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha) {
+    if (!state.setBlendFunc(srcRgb, dstRgb, srcAlpha, dstAlpha)) counters.redundant++;
+    note(OP_BLEND_FUNC, srcRgb, dstRgb, srcAlpha, dstAlpha);
+}
+
+void NullRenderDevice::clear(const glm::vec4& color) {
+    note(OP_CLEAR, fnv1a(&color[0], sizeof(float) * 4));
+}
+
+void NullRenderDevice::drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    counters.instances += instances;
+    note(OP_DRAW_INSTANCED, mode, first, count, instances);
+}
+
+void CaptureRenderDevice::note(RenderOp op, uint64_t a, uint64_t b, uint64_t c, uint64_t d) {
+    NullRenderDevice::note(op, a, b, c, d);
+    commands.push_back({ op, { a, b, c, d } });
+}
+
+std::string CaptureRenderDevice::text() const {
+    std::string out;
+    for (const auto& cmd : commands) {
+        out += renderOpName(cmd.op);
+        int n = 4;
+        while (n > 0 && cmd.args[n - 1] == 0) n--;
+        for (int i = 0; i < n; ++i) out += " " + std::to_string(cmd.args[i]);
+        out += "\n";
+    }
+    return out;
+}
+
+long long CachingRenderDevice::filteredTotal() const {
+    long long n = 0;
+    for (long long c : filtered) n += c;
+    return n;
+}
+
+void CachingRenderDevice::resetCounters() {
+    std::fill(filtered, filtered + OP_COUNT, 0);
+}
+
+GLuint CachingRenderDevice::createBuffer() {
+    return target.createBuffer();
+}
+
+void CachingRenderDevice::bindBuffer(GLenum t, GLuint buffer) {
+    if (pass(state.setBuffer(t, buffer), OP_BIND_BUFFER)) target.bindBuffer(t, buffer);
+}
+
+void CachingRenderDevice::bufferData(GLenum t, size_t bytes, const void* data, GLenum usage) {
+    target.bufferData(t, bytes, data, usage);
+}
+
+void CachingRenderDevice::bufferSubData(GLenum t, size_t offset, size_t bytes, const void* data) {
+    target.bufferSubData(t, offset, bytes, data);
+}
+
+void* CachingRenderDevice::bufferStoragePersistent(GLenum t, size_t bytes) {
+    return target.bufferStoragePersistent(t, bytes);
+}
+
+void* CachingRenderDevice::mapBufferRange(GLenum t, size_t offset, size_t bytes, GLbitfield access) {
+    return target.mapBufferRange(t, offset, bytes, access);
+}
+
+void CachingRenderDevice::unmapBuffer(GLenum t) {
+    target.unmapBuffer(t);
+}
+
+GLsync CachingRenderDevice::fence() {
+    return target.fence();
+}
+
+bool CachingRenderDevice::waitFence(GLsync fence, uint64_t timeoutNanos) {
+    return target.waitFence(fence, timeoutNanos);
+}
+
+void CachingRenderDevice::deleteFence(GLsync fence) {
+    target.deleteFence(fence);
+}
+
+void CachingRenderDevice::bindVertexArray(GLuint vao) {
+    if (pass(state.setVertexArray(vao), OP_BIND_VERTEX_ARRAY)) target.bindVertexArray(vao);
+}
+
+void CachingRenderDevice::enableVertexAttribArray(GLuint index) {
+    if (pass(state.enableAttrib(index), OP_ENABLE_ATTRIB)) target.enableVertexAttribArray(index);
+}
+
+void CachingRenderDevice::vertexAttribPointer(GLuint index, GLint components, GLsizei stride, size_t offset) {
+    if (pass(state.setAttribPointer(index, components, stride, offset), OP_ATTRIB_POINTER))
+        target.vertexAttribPointer(index, components, stride, offset);
+}
+
+void CachingRenderDevice::vertexAttribDivisor(GLuint index, GLuint divisor) {
+    if (pass(state.setAttribDivisor(index, divisor), OP_ATTRIB_DIVISOR)) target.vertexAttribDivisor(index, divisor);
+}
+
+void CachingRenderDevice::useProgram(GLuint program) {
+    if (pass(state.setProgram(program), OP_USE_PROGRAM)) target.useProgram(program);
+}
+
+GLint CachingRenderDevice::uniformLocation(GLuint program, const char* name) {
+    return target.uniformLocation(program, name);
+}
+
+void CachingRenderDevice::uniformMatrix4(GLint location, const glm::mat4& m) {
+    if (pass(state.setUniform(location, m), OP_UNIFORM_MATRIX)) target.uniformMatrix4(location, m);
+}
+
+void CachingRenderDevice::uniform1i(GLint location, GLint value) {
+    if (pass(state.setUniform(location, value), OP_UNIFORM_INT)) target.uniform1i(location, value);
+}
+
+void CachingRenderDevice::activeTexture(GLenum unit) {
+    if (pass(state.setActiveTexture(unit), OP_ACTIVE_TEXTURE)) target.activeTexture(unit);
+}
+
+void CachingRenderDevice::bindTexture(GLenum t, GLuint texture) {
+    if (pass(state.setTexture(t, texture), OP_BIND_TEXTURE)) target.bindTexture(t, texture);
+}
+
+void CachingRenderDevice::setBlend(bool enabled) {
+    if (pass(state.setBlend(enabled), OP_BLEND_ENABLE)) target.setBlend(enabled);
+}
+
+void CachingRenderDevice::blendFuncSeparate(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha) {
+    if (pass(state.setBlendFunc(srcRgb, dstRgb, srcAlpha, dstAlpha), OP_BLEND_FUNC))
+        target.blendFuncSeparate(srcRgb, dstRgb, srcAlpha, dstAlpha);
+}
+
+void CachingRenderDevice::clear(const glm::vec4& color) {
+    target.clear(color);
+}
+
+void CachingRenderDevice::drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    target.drawArraysInstanced(mode, first, count, instances);
+}
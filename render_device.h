@@ -0,0 +1,236 @@
+#pragma once
+
+#include "render_state.h"
+
+#include <glad.h>
+#include <glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+// Every GL call the per-frame render path makes (the batches, the stream
+// buffers, the clear) goes through a RenderDevice, so that path can be run,
+// counted and recorded without a GL context. One-off setup (shaders, vertex
+// arrays, textures, timer queries) still calls GL directly.
+enum RenderOp {
+    OP_CREATE_BUFFER, OP_BIND_BUFFER, OP_BUFFER_DATA, OP_BUFFER_SUB_DATA, OP_BUFFER_STORAGE,
+    OP_MAP_BUFFER, OP_UNMAP_BUFFER,
+    OP_FENCE, OP_WAIT_FENCE, OP_DELETE_FENCE,
+    OP_BIND_VERTEX_ARRAY, OP_ENABLE_ATTRIB, OP_ATTRIB_POINTER, OP_ATTRIB_DIVISOR,
+    OP_USE_PROGRAM, OP_UNIFORM_LOCATION, OP_UNIFORM_MATRIX, OP_UNIFORM_INT,
+    OP_ACTIVE_TEXTURE, OP_BIND_TEXTURE,
+    OP_BLEND_ENABLE, OP_BLEND_FUNC,
+    OP_CLEAR, OP_DRAW_INSTANCED,
+    OP_COUNT
+};
+
+const char* renderOpName(RenderOp op);
+
+class RenderDevice {
+public:
+    virtual ~RenderDevice() {}
+
+    virtual GLuint createBuffer() = 0;
+    virtual void bindBuffer(GLenum target, GLuint buffer) = 0;
+    virtual void bufferData(GLenum target, size_t bytes, const void* data, GLenum usage) = 0;
+    virtual void bufferSubData(GLenum target, size_t offset, size_t bytes, const void* data) = 0;
+    // Gives the bound buffer immutable storage mapped persistently and
+    // coherently for writing. nullptr if the device cannot (before GL 4.4).
+    virtual void* bufferStoragePersistent(GLenum target, size_t bytes) = 0;
+    virtual void* mapBufferRange(GLenum target, size_t offset, size_t bytes, GLbitfield access) = 0;
+    virtual void unmapBuffer(GLenum target) = 0;
+
+    virtual GLsync fence() = 0;
+    // True if the fence had already signalled; otherwise waits up to `timeoutNanos`.
+    virtual bool waitFence(GLsync fence, uint64_t timeoutNanos) = 0;
+    virtual void deleteFence(GLsync fence) = 0;
+
+    virtual void bindVertexArray(GLuint vao) = 0;
+    virtual void enableVertexAttribArray(GLuint index) = 0;
+    // A float attribute of `components` floats, `offset` bytes into the bound buffer.
+    virtual void vertexAttribPointer(GLuint index, GLint components, GLsizei stride, size_t offset) = 0;
+    virtual void vertexAttribDivisor(GLuint index, GLuint divisor) = 0;
+
+    virtual void useProgram(GLuint program) = 0;
+    virtual GLint uniformLocation(GLuint program, const char* name) = 0;
+    virtual void uniformMatrix4(GLint location, const glm::mat4& m) = 0;
+    virtual void uniform1i(GLint location, GLint value) = 0;
+    virtual void activeTexture(GLenum unit) = 0;
+    virtual void bindTexture(GLenum target, GLuint texture) = 0;
+    virtual void setBlend(bool enabled) = 0;
+    virtual void blendFuncSeparate(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha) = 0;
+
+    virtual void clear(const glm::vec4& color) = 0;
+    virtual void drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) = 0;
+};
+
+// The GL context current on the calling thread.
+class GlRenderDevice : public RenderDevice {
+public:
+    GLuint createBuffer() override;
+    void bindBuffer(GLenum target, GLuint buffer) override;
+    void bufferData(GLenum target, size_t bytes, const void* data, GLenum usage) override;
+    void bufferSubData(GLenum target, size_t offset, size_t bytes, const void* data) override;
+    void* bufferStoragePersistent(GLenum target, size_t bytes) override;
+    void* mapBufferRange(GLenum target, size_t offset, size_t bytes, GLbitfield access) override;
+    void unmapBuffer(GLenum target) override;
+    GLsync fence() override;
+    bool waitFence(GLsync fence, uint64_t timeoutNanos) override;
+    void deleteFence(GLsync fence) override;
+    void bindVertexArray(GLuint vao) override;
+    void enableVertexAttribArray(GLuint index) override;
+    void vertexAttribPointer(GLuint index, GLint components, GLsizei stride, size_t offset) override;
+    void vertexAttribDivisor(GLuint index, GLuint divisor) override;
+    void useProgram(GLuint program) override;
+    GLint uniformLocation(GLuint program, const char* name) override;
+    void uniformMatrix4(GLint location, const glm::mat4& m) override;
+    void uniform1i(GLint location, GLint value) override;
+    void activeTexture(GLenum unit) override;
+    void bindTexture(GLenum target, GLuint texture) override;
+    void setBlend(bool enabled) override;
+    void blendFuncSeparate(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha) override;
+    void clear(const glm::vec4& color) override;
+    void drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) override;
+};
+
+// Brackets the passes of a frame, e.g. with GPU timer queries (GpuTimer).
+class PassTimer {
+public:
+    virtual ~PassTimer() {}
+    virtual void beginFrame() = 0;
+    // `pass` must be a string literal. Passes cannot nest.
+    virtual void begin(const char* pass) = 0;
+    virtual void end() = 0;
+};
+
+struct DeviceCounters {
+    long long calls[OP_COUNT] = {};
+    long long redundant = 0;   // calls that set state already in place
+    long long instances = 0;
+    size_t bytes = 0;          // buffer data written, or mapped for writing
+
+    long long total() const;
+    long long draws() const { return calls[OP_DRAW_INSTANCED]; }
+    void reset() { *this = DeviceCounters(); }
+};
+
+// Does no rendering. Counts every call and tracks state (see RenderState)
+// to tell state changes from redundant calls.
+// Names are handed out from 1 up; mapped ranges point at scratch memory.
+class NullRenderDevice : public RenderDevice {
+public:
+    // With `persistentMapping`, behaves like a GL 4.4 device.
+    explicit NullRenderDevice(bool persistentMapping = false) : persistent(persistentMapping) {}
+
+    GLuint createBuffer() override;
+    void bindBuffer(GLenum target, GLuint buffer) override;
+    void bufferData(GLenum target, size_t bytes, const void* data, GLenum usage) override;
+    void bufferSubData(GLenum target, size_t offset, size_t bytes, const void* data) override;
+    void* bufferStoragePersistent(GLenum target, size_t bytes) override;
+    void* mapBufferRange(GLenum target, size_t offset, size_t bytes, GLbitfield access) override;
+    void unmapBuffer(GLenum target) override;
+    GLsync fence() override;
+    bool waitFence(GLsync fence, uint64_t timeoutNanos) override;
+    void deleteFence(GLsync fence) override;
+    void bindVertexArray(GLuint vao) override;
+    void enableVertexAttribArray(GLuint index) override;
+    void vertexAttribPointer(GLuint index, GLint components, GLsizei stride, size_t offset) override;
+    void vertexAttribDivisor(GLuint index, GLuint divisor) override;
+    void useProgram(GLuint program) override;
+    GLint uniformLocation(GLuint program, const char* name) override;
+    void uniformMatrix4(GLint location, const glm::mat4& m) override;
+    void uniform1i(GLint location, GLint value) override;
+    void activeTexture(GLenum unit) override;
+    void bindTexture(GLenum target, GLuint texture) override;
+    void setBlend(bool enabled) override;
+    void blendFuncSeparate(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha) override;
+    void clear(const glm::vec4& color) override;
+    void drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) override;
+
+    DeviceCounters counters;
+
+protected:
+    // Every call lands here once, with its arguments.
+    virtual void note(RenderOp op, uint64_t a = 0, uint64_t b = 0, uint64_t c = 0, uint64_t d = 0);
+
+private:
+    bool persistent;
+    GLuint nextName = 1;
+    RenderState state;
+    std::map<GLenum, GLuint> buffers;
+    std::map<GLuint, std::vector<unsigned char>> storage;   // persistently mapped buffers
+    std::vector<unsigned char> scratch;
+};
+
+struct RenderCommand {
+    RenderOp op;
+    uint64_t args[4];
+};
+
+// A NullRenderDevice that also keeps the command stream, for comparing what
+// two runs of the render path submit. Matrices are kept as a hash.
+class CaptureRenderDevice : public NullRenderDevice {
+public:
+    using NullRenderDevice::NullRenderDevice;
+
+    std::vector<RenderCommand> commands;
+
+    // One command per line, its name followed by its arguments.
+    std::string text() const;
+
+protected:
+    void note(RenderOp op, uint64_t a, uint64_t b, uint64_t c, uint64_t d) override;
+};
+
+// Sits in front of another device and drops the calls that would leave state
+// as it is. GL calls made behind its back (texture uploads, one-off setup)
+// must be followed by invalidate().
+class CachingRenderDevice : public RenderDevice {
+public:
+    explicit CachingRenderDevice(RenderDevice& target) : target(target) {}
+
+    void invalidate() { state.invalidate(); }
+
+    // Calls dropped since the last resetCounters(), by kind.
+    long long filtered[OP_COUNT] = {};
+    long long filteredTotal() const;
+    void resetCounters();
+
+    GLuint createBuffer() override;
+    void bindBuffer(GLenum target, GLuint buffer) override;
+    void bufferData(GLenum target, size_t bytes, const void* data, GLenum usage) override;
+    void bufferSubData(GLenum target, size_t offset, size_t bytes, const void* data) override;
+    void* bufferStoragePersistent(GLenum target, size_t bytes) override;
+    void* mapBufferRange(GLenum target, size_t offset, size_t bytes, GLbitfield access) override;
+    void unmapBuffer(GLenum target) override;
+    GLsync fence() override;
+    bool waitFence(GLsync fence, uint64_t timeoutNanos) override;
+    void deleteFence(GLsync fence) override;
+    void bindVertexArray(GLuint vao) override;
+    void enableVertexAttribArray(GLuint index) override;
+    void vertexAttribPointer(GLuint index, GLint components, GLsizei stride, size_t offset) override;
+    void vertexAttribDivisor(GLuint index, GLuint divisor) override;
+    void useProgram(GLuint program) override;
+    GLint uniformLocation(GLuint program, const char* name) override;
+    void uniformMatrix4(GLint location, const glm::mat4& m) override;
+    void uniform1i(GLint location, GLint value) override;
+    void activeTexture(GLenum unit) override;
+    void bindTexture(GLenum target, GLuint texture) override;
+    void setBlend(bool enabled) override;
+    void blendFuncSeparate(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha) override;
+    void clear(const glm::vec4& color) override;
+    void drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) override;
+
+private:
+    // True if the call must go through; counts it as filtered otherwise.
+    bool pass(bool changed, RenderOp op) {
+        if (!changed) filtered[op]++;
+        return changed;
+    }
+
+    RenderDevice& target;
+    RenderState state;
+};
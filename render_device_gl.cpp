@@ -0,0 +1,106 @@
+#include "render_device.h"
+
+GLuint GlRenderDevice::createBuffer() {
+    GLuint buffer = 0;
+    glGenBuffers(1, &buffer);
+    return buffer;
+}
+
+void GlRenderDevice::bindBuffer(GLenum target, GLuint buffer) {
+    glBindBuffer(target, buffer);
+}
+
+void GlRenderDevice::bufferData(GLenum target, size_t bytes, const void* data, GLenum usage) {
+    glBufferData(target, bytes, data, usage);
+}
+
+void GlRenderDevice::bufferSubData(GLenum target, size_t offset, size_t bytes, const void* data) {
+    glBufferSubData(target, offset, bytes, data);
+}
+
+void* GlRenderDevice::bufferStoragePersistent(GLenum target, size_t bytes) {
+    if (!GLAD_GL_VERSION_4_4 || !glBufferStorage) return nullptr;
+    const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    glBufferStorage(target, bytes, nullptr, flags);
+    return glMapBufferRange(target, 0, bytes, flags);
+}
+
+void* GlRenderDevice::mapBufferRange(GLenum target, size_t offset, size_t bytes, GLbitfield access) {
+    return glMapBufferRange(target, offset, bytes, access);
+}
+
+void GlRenderDevice::unmapBuffer(GLenum target) {
+    glUnmapBuffer(target);
+}
+
+GLsync GlRenderDevice::fence() {
+    return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool GlRenderDevice::waitFence(GLsync fence, uint64_t timeoutNanos) {
+    if (glClientWaitSync(fence, 0, 0) != GL_TIMEOUT_EXPIRED) return true;
+    glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, timeoutNanos);
+    return false;
+}
+
+void GlRenderDevice::deleteFence(GLsync fence) {
+    glDeleteSync(fence);
+}
+
+void GlRenderDevice::bindVertexArray(GLuint vao) {
+    glBindVertexArray(vao);
+}
+
+void GlRenderDevice::enableVertexAttribArray(GLuint index) {
+    glEnableVertexAttribArray(index);
+}
+
+void GlRenderDevice::vertexAttribPointer(GLuint index, GLint components, GLsizei stride, size_t offset) {
+    glVertexAttribPointer(index, components, GL_FLOAT, GL_FALSE, stride, (void*)offset);
+}
+
+void GlRenderDevice::vertexAttribDivisor(GLuint index, GLuint divisor) {
+    glVertexAttribDivisor(index, divisor);
+}
+
+void GlRenderDevice::useProgram(GLuint program) {
+    glUseProgram(program);
+}
+
+GLint GlRenderDevice::uniformLocation(GLuint program, const char* name) {
+    return glGetUniformLocation(program, name);
+}
+
+void GlRenderDevice::uniformMatrix4(GLint location, const glm::mat4& m) {
+    glUniformMatrix4fv(location, 1, GL_FALSE, &m[0][0]);
+}
+
+void GlRenderDevice::uniform1i(GLint location, GLint value) {
+    glUniform1i(location, value);
+}
+
+void GlRenderDevice::activeTexture(GLenum unit) {
+    glActiveTexture(unit);
+}
+
+void GlRenderDevice::bindTexture(GLenum target, GLuint texture) {
+    glBindTexture(target, texture);
+}
+
+void GlRenderDevice::setBlend(bool enabled) {
+    if (enabled) glEnable(GL_BLEND);
+    else glDisable(GL_BLEND);
+}
+
+void GlRenderDevice::blendFuncSeparate(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha) {
+    glBlendFuncSeparate(srcRgb, dstRgb, srcAlpha, dstAlpha);
+}
+
+void GlRenderDevice::clear(const glm::vec4& color) {
+    glClearColor(color.x, color.y, color.z, color.w);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void GlRenderDevice::drawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances) {
+    glDrawArraysInstanced(mode, first, count, instances);
+}
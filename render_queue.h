@@ -0,0 +1,54 @@
+#pragma once
+
+#include "frame_arena.h"
+#include "game_world.h"
+#include "sprite_batch.h"
+
+#include <glm.hpp>
+
+#include <cstdint>
+
+enum RenderPass { PASS_OPAQUE, PASS_TRANSPARENT };
+
+// Draw order of a queued sprite, most significant bits first:
+//   opaque:      pass:2 | program:8 | texture:16 | material:14 | depth:24
+//   transparent: pass:2 | depth:24 | program:8 | texture:16 | material:14
+// Opaque sprites are grouped by state and go front to back within a group;
+// transparent ones go back to front (larger depth first) and are only
+// grouped by state where their depths tie. Fields wider than their bits
+// keep their low bits, which can merge groups but never breaks depth order.
+uint64_t renderKey(RenderPass pass, float depth, uint32_t program, uint32_t texture, uint32_t material);
+
+struct RenderItem {
+    uint64_t key;
+    int sprite;
+};
+
+// Sorts `items` by key, keeping the order of equal keys: an LSD radix sort
+// over the key bytes that differ, or a merge sort for queues that fit in cache.
+// `scratch` must hold `n` items; returns whichever of the two ends up holding
+// the result.
+RenderItem* radixSort(RenderItem* items, RenderItem* scratch, int n);
+
+// The dynamic sprites of one frame. The arrays live in a FrameArena and are
+// sized up front, so building and sorting the queue never allocates.
+struct RenderQueue {
+    Sprite* sprites = nullptr;   // in push order
+    RenderItem* items = nullptr;   // in draw order after sort()
+    RenderItem* scratch = nullptr;
+    int count = 0, capacity = 0;
+
+    void begin(FrameArena& arena, int maxSprites);
+    // Sprites one SpriteBatch cannot draw together need a different program
+    // or material; everything queued today uses the sprite program.
+    void push(const Sprite& s, uint32_t program = 0, uint32_t material = 0);
+    void sort();
+
+    // The i-th sprite in draw order.
+    const Sprite& operator[](int i) const { return sprites[items[i].sprite]; }
+};
+
+// Queues the paddle, balls and power-ups at the interpolated positions.
+// Bricks are not queued; they live in a BrickInstanceBuffer.
+void queueWorld(const GameWorld& world, float alpha, const SpriteSkin& skin, FrameArena& arena,
+    RenderQueue& queue);
@@ -0,0 +1,140 @@
+#include "render_state.h"
+
+#include <algorithm>
+#include <cstring>
+
+void RenderState::invalidate() {
+    program = vao = arrayBuffer = kUnknown;
+    unit = -1;
+    std::fill(textures, textures + kTextureUnits, kUnknown);
+    blend = -1;
+    std::fill(blendFunc, blendFunc + 4, kUnknown);
+    // clear() keeps the capacity, so invalidating every frame does not allocate.
+    arrays.clear();
+    uniforms.clear();
+}
+
+bool RenderState::setProgram(GLuint p) {
+    if (program == p) return false;
+    program = p;
+    return true;
+}
+
+bool RenderState::setVertexArray(GLuint array) {
+    if (vao == array) return false;
+    vao = array;
+    return true;
+}
+
+bool RenderState::setBuffer(GLenum target, GLuint buffer) {
+    if (target != GL_ARRAY_BUFFER) return true;
+    if (arrayBuffer == buffer) return false;
+    arrayBuffer = buffer;
+    return true;
+}
+
+bool RenderState::setActiveTexture(GLenum texUnit) {
+    int u = (int)(texUnit - GL_TEXTURE0);
+    if (u < 0 || u >= kTextureUnits) {
+        unit = -1;
+        return true;
+    }
+    if (unit == u) return false;
+    unit = u;
+    return true;
+}
+
+bool RenderState::setTexture(GLenum target, GLuint texture) {
+    if (target != GL_TEXTURE_2D || unit < 0) return true;
+    if (textures[unit] == texture) return false;
+    textures[unit] = texture;
+    return true;
+}
+
+bool RenderState::setBlend(bool enabled) {
+    if (blend == (int)enabled) return false;
+    blend = enabled;
+    return true;
+}
+
+bool RenderState::setBlendFunc(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha) {
+    GLenum f[4] = { srcRgb, dstRgb, srcAlpha, dstAlpha };
+    if (std::equal(f, f + 4, blendFunc)) return false;
+    std::copy(f, f + 4, blendFunc);
+    return true;
+}
+
+RenderState::Attrib* RenderState::attrib(GLuint index) {
+    // Nothing is known about vertex array 0 or one bound behind our back.
+    if (vao == 0 || vao == kUnknown || index >= (GLuint)kAttribs) return nullptr;
+    for (auto& a : arrays)
+        if (a.name == vao) return &a.attribs[index];
+    VertexArray a;
+    a.name = vao;
+    for (auto& at : a.attribs) at = { -1, kUnknown, kUnknown, 0, 0, 0 };
+    arrays.push_back(a);
+    return &arrays.back().attribs[index];
+}
+
+bool RenderState::enableAttrib(GLuint index) {
+    Attrib* a = attrib(index);
+    if (!a) return true;
+    if (a->enabled == 1) return false;
+    a->enabled = 1;
+    return true;
+}
+
+bool RenderState::setAttribDivisor(GLuint index, GLuint divisor) {
+    Attrib* a = attrib(index);
+    if (!a) return true;
+    if (a->divisor == divisor) return false;
+    a->divisor = divisor;
+    return true;
+}
+
+bool RenderState::setAttribPointer(GLuint index, GLint components, GLsizei stride, size_t offset) {
+    Attrib* a = attrib(index);
+    if (!a) return true;
+    // The pointer captures whatever is bound to GL_ARRAY_BUFFER.
+    if (arrayBuffer != kUnknown && a->buffer == arrayBuffer && a->components == components &&
+        a->stride == stride && a->offset == offset)
+        return false;
+    a->buffer = arrayBuffer;
+    a->components = components;
+    a->stride = stride;
+    a->offset = offset;
+    return true;
+}
+
+RenderState::Uniform* RenderState::uniform(GLint location, bool matrix) {
+    if (program == kUnknown || location < 0) return nullptr;
+    for (auto& u : uniforms)
+        if (u.program == program && u.location == location && u.matrix == matrix) return &u;
+    return nullptr;
+}
+
+bool RenderState::setUniform(GLint location, const glm::mat4& value) {
+    if (program == kUnknown || location < 0) return true;
+    Uniform* u = uniform(location, true);
+    if (u && std::memcmp(&u->value[0][0], &value[0][0], sizeof(float) * 16) == 0) return false;
+    if (!u) {
+        uniforms.push_back({ program, location, true, value });
+        return true;
+    }
+    u->value = value;
+    return true;
+}
+
+bool RenderState::setUniform(GLint location, GLint value) {
+    if (program == kUnknown || location < 0) return true;
+    Uniform* u = uniform(location, false);
+    glm::mat4 stored(0.0f);
+    std::memcpy(&stored[0][0], &value, sizeof(value));
+    if (u && std::memcmp(&u->value[0][0], &stored[0][0], sizeof(value)) == 0) return false;
+    if (!u) {
+        uniforms.push_back({ program, location, false, stored });
+        return true;
+    }
+    u->value = stored;
+    return true;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <glad.h>
+#include <glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// What a GL context has bound, as far as the calls seen so far tell. Each
+// set* records the new value and returns false when it was already in
+// place, i.e. when the call would be redundant. Everything starts unknown,
+// so the first call of each kind always counts as a change.
+//
+// Tracked: program, vertex array and the attributes of each vertex array,
+// GL_ARRAY_BUFFER, active texture unit and the GL_TEXTURE_2D bound to each
+// unit, blending, and uniform values per program. Other targets always
+// count as a change.
+class RenderState {
+public:
+    static const int kAttribs = 8;
+    static const int kTextureUnits = 16;
+
+    RenderState() { invalidate(); }
+
+    // Forgets everything, e.g. after GL calls this state did not see.
+    void invalidate();
+
+    bool setProgram(GLuint program);
+    bool setVertexArray(GLuint vao);
+    bool setBuffer(GLenum target, GLuint buffer);
+    bool setActiveTexture(GLenum unit);
+    bool setTexture(GLenum target, GLuint texture);
+    bool setBlend(bool enabled);
+    bool setBlendFunc(GLenum srcRgb, GLenum dstRgb, GLenum srcAlpha, GLenum dstAlpha);
+
+    // On the bound vertex array.
+    bool enableAttrib(GLuint index);
+    bool setAttribDivisor(GLuint index, GLuint divisor);
+    bool setAttribPointer(GLuint index, GLint components, GLsizei stride, size_t offset);
+
+    // On the program in use.
+    bool setUniform(GLint location, const glm::mat4& value);
+    bool setUniform(GLint location, GLint value);
+
+private:
+    static const GLuint kUnknown = 0xFFFFFFFFu;
+
+    struct Attrib {
+        int enabled;   // -1 unknown
+        GLuint divisor;
+        GLuint buffer;   // kUnknown when the pointer is unknown
+        GLint components;
+        GLsizei stride;
+        size_t offset;
+    };
+    struct VertexArray {
+        GLuint name;
+        Attrib attribs[kAttribs];
+    };
+    struct Uniform {
+        GLuint program;
+        GLint location;
+        bool matrix;
+        glm::mat4 value;
+    };
+
+    Attrib* attrib(GLuint index);
+    Uniform* uniform(GLint location, bool matrix);
+
+    GLuint program, vao, arrayBuffer;
+    int unit;
+    GLuint textures[kTextureUnits];
+    int blend;   // -1 unknown
+    GLenum blendFunc[4];
+    std::vector<VertexArray> arrays;
+    std::vector<Uniform> uniforms;
+};
@@ -0,0 +1,248 @@
+#include "replay.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+namespace {
+
+const char kMagic[4] = { 'A', 'R', 'K', 'R' };
+const uint16_t kVersion = 4;   // 2: PCG32 world generator, stream id; 3: pooled balls, pool sizes; 4: level file
+
+struct Writer {
+    std::vector<uint8_t>& out;
+
+    void raw(const void* p, size_t n) {
+        const uint8_t* b = (const uint8_t*)p;
+        out.insert(out.end(), b, b + n);
+    }
+    template <typename T>
+    void pod(T v) {
+        uint8_t b[sizeof(T)];
+        std::memcpy(b, &v, sizeof(T));
+        raw(b, sizeof(T));
+    }
+    void varint(uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back((uint8_t)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((uint8_t)v);
+    }
+};
+
+struct Reader {
+    const uint8_t* p;
+    const uint8_t* end;
+    bool ok = true;
+
+    void raw(void* dst, size_t n) {
+        if ((size_t)(end - p) < n) {
+            ok = false;
+            std::memset(dst, 0, n);
+            return;
+        }
+        std::memcpy(dst, p, n);
+        p += n;
+    }
+    template <typename T>
+    T pod() {
+        T v;
+        raw(&v, sizeof(T));
+        return v;
+    }
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p == end) break;
+            uint8_t b = *p++;
+            v |= (uint64_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        ok = false;
+        return 0;
+    }
+};
+
+bool sameBits(float a, float b) {
+    return std::memcmp(&a, &b, sizeof(float)) == 0;
+}
+
+// The header goes straight into GameWorld and its pools; keep it to sizes a
+// real game could have.
+bool plausibleConfig(const WorldConfig& c) {
+    return c.width > 0.0f && c.width <= 100000.0f && c.height > 0.0f && c.height <= 100000.0f &&
+        c.rows >= 0 && c.rows <= 1024 && c.cols >= 1 && c.cols <= 1024 &&
+        c.lives >= 1 && c.lives <= 1000000 &&
+        c.maxBalls >= 1 && c.maxBalls <= 65536 && c.maxPowerUps >= 0 && c.maxPowerUps <= 65536;
+}
+
+}
+
+void ReplayRecorder::begin(const WorldConfig& config, double simHz, int hashInterval) {
+    data = Replay();
+    data.config = config;
+    if (config.level) {
+        data.levelPath = config.level->path();
+        data.levelChecksum = config.level->header().checksum;
+    }
+    data.simHz = simHz;
+    data.hashInterval = hashInterval;
+}
+
+void ReplayRecorder::record(const GameInput& input, const GameWorld& after) {
+    data.inputs.push_back(input.paddleX);
+    if (data.inputs.size() % data.hashInterval == 0)
+        data.hashes.push_back(after.stateHash());
+}
+
+void encodeReplay(const Replay& replay, std::vector<uint8_t>& out) {
+    out.clear();
+    Writer w{ out };
+    w.raw(kMagic, 4);
+    w.pod<uint16_t>(kVersion);
+    w.pod<uint32_t>(replay.config.seed);
+    w.pod<uint32_t>(replay.config.stream);
+    w.pod<float>(replay.config.width);
+    w.pod<float>(replay.config.height);
+    w.pod<int32_t>(replay.config.rows);
+    w.pod<int32_t>(replay.config.cols);
+    w.pod<int32_t>(replay.config.lives);
+    w.pod<int32_t>(replay.config.brickPoints);
+    w.pod<int32_t>(replay.config.maxBalls);
+    w.pod<int32_t>(replay.config.maxPowerUps);
+    w.varint(replay.levelPath.size());
+    w.raw(replay.levelPath.data(), replay.levelPath.size());
+    w.pod<uint64_t>(replay.levelChecksum);
+    w.pod<double>(replay.simHz);
+    w.pod<uint32_t>((uint32_t)replay.hashInterval);
+    w.varint(replay.inputs.size());
+
+    for (size_t i = 0; i < replay.inputs.size();) {
+        size_t run = 1;
+        while (i + run < replay.inputs.size() && sameBits(replay.inputs[i + run], replay.inputs[i])) run++;
+        w.varint(run);
+        w.pod<float>(replay.inputs[i]);
+        i += run;
+    }
+
+    w.varint(replay.hashes.size());
+    for (uint64_t h : replay.hashes) w.pod<uint64_t>(h);
+}
+
+bool decodeReplay(const uint8_t* bytes, size_t size, Replay& out) {
+    Reader r{ bytes, bytes + size };
+    char magic[4];
+    r.raw(magic, 4);
+    if (!r.ok || std::memcmp(magic, kMagic, 4) != 0) return false;
+    if (r.pod<uint16_t>() != kVersion) return false;
+
+    out = Replay();
+    out.config.seed = r.pod<uint32_t>();
+    out.config.stream = r.pod<uint32_t>();
+    out.config.width = r.pod<float>();
+    out.config.height = r.pod<float>();
+    out.config.rows = r.pod<int32_t>();
+    out.config.cols = r.pod<int32_t>();
+    out.config.lives = r.pod<int32_t>();
+    out.config.brickPoints = r.pod<int32_t>();
+    out.config.maxBalls = r.pod<int32_t>();
+    out.config.maxPowerUps = r.pod<int32_t>();
+    if (!r.ok || !plausibleConfig(out.config)) return false;
+    uint64_t pathBytes = r.varint();
+    if (!r.ok || pathBytes > (uint64_t)(r.end - r.p)) return false;
+    out.levelPath.assign((const char*)r.p, (size_t)pathBytes);
+    r.p += pathBytes;
+    out.levelChecksum = r.pod<uint64_t>();
+    out.simHz = r.pod<double>();
+    out.hashInterval = (int)r.pod<uint32_t>();
+    uint64_t steps = r.varint();
+    if (!r.ok || out.hashInterval <= 0 || !(out.simHz > 0.0) || steps > kMaxReplaySteps) return false;
+
+    while (r.ok && out.inputs.size() < steps) {
+        uint64_t run = r.varint();
+        float x = r.pod<float>();
+        if (run == 0 || run > steps - out.inputs.size()) return false;
+        out.inputs.insert(out.inputs.end(), (size_t)run, x);
+    }
+
+    uint64_t hashCount = r.varint();
+    if (!r.ok || hashCount > steps / out.hashInterval || hashCount > (uint64_t)(r.end - r.p) / sizeof(uint64_t))
+        return false;
+    out.hashes.resize((size_t)hashCount);
+    for (auto& h : out.hashes) h = r.pod<uint64_t>();
+    return r.ok;
+}
+
+bool saveReplay(const std::string& path, const Replay& replay) {
+    std::vector<uint8_t> bytes;
+    encodeReplay(replay, bytes);
+    std::ofstream file(path, std::ios::binary);
+    file.write((const char*)bytes.data(), bytes.size());
+    return (bool)file;
+}
+
+bool loadReplay(const std::string& path, Replay& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    std::vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return decodeReplay(bytes.data(), bytes.size(), out);
+}
+
+ReplayResult playReplay(const Replay& replay) {
+    ReplayResult result;
+    auto t0 = std::chrono::steady_clock::now();
+
+    GameWorld world(replay.config);
+    const float dt = (float)(1.0 / replay.simHz);
+    GameInput input;
+    for (size_t i = 0; i < replay.inputs.size(); ++i) {
+        input.paddleX = replay.inputs[i];
+        world.step(dt, input);
+        result.steps++;
+        if (result.steps % replay.hashInterval == 0) {
+            size_t h = (size_t)(result.steps / replay.hashInterval) - 1;
+            if (h < replay.hashes.size() && world.stateHash() != replay.hashes[h]) {
+                result.mismatchStep = result.steps;
+                break;
+            }
+        }
+    }
+
+    result.finalHash = world.stateHash();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    return result;
+}
+
+int runReplay(const std::string& path) {
+    Replay replay;
+    if (!loadReplay(path, replay)) {
+        std::printf("could not read replay '%s'\n", path.c_str());
+        return 1;
+    }
+    if (!replay.levelPath.empty()) {
+        std::string error;
+        replay.config.level = loadLevel(replay.levelPath, error);
+        if (!replay.config.level) {
+            std::printf("%s: %s\n", replay.levelPath.c_str(), error.c_str());
+            return 1;
+        }
+        if (replay.config.level->header().checksum != replay.levelChecksum) {
+            std::printf("%s has changed since the replay was recorded\n", replay.levelPath.c_str());
+            return 1;
+        }
+    }
+    ReplayResult r = playReplay(replay);
+    double gameSeconds = r.steps / replay.simHz;
+    std::printf("%s: seed %u, %lld steps (%.1f s of play at %g Hz) in %.3f s, %.0fx real time\n",
+        path.c_str(), replay.config.seed, r.steps, gameSeconds, replay.simHz, r.seconds,
+        r.seconds > 0.0 ? gameSeconds / r.seconds : 0.0);
+    if (r.mismatchStep >= 0) {
+        std::printf("DIVERGED: state hash differs after step %lld\n", r.mismatchStep);
+        return 1;
+    }
+    std::printf("all %zu state hashes match, final %016llx\n", replay.hashes.size(), (unsigned long long)r.finalHash);
+    return 0;
+}
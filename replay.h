@@ -0,0 +1,62 @@
+#pragma once
+
+#include "game_world.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Everything needed to re-run a game bit for bit: the world setup, the seed
+// (in config) and the paddle input of every fixed step, plus a state hash
+// every hashInterval steps to catch divergence early.
+struct Replay {
+    WorldConfig config;
+    // The level the game was played on, if any. config.level is not saved;
+    // whoever plays the replay opens the file and checks the checksum.
+    std::string levelPath;
+    uint64_t levelChecksum = 0;
+    double simHz = 240.0;
+    int hashInterval = 240;
+    std::vector<float> inputs;      // GameInput::paddleX, one per step
+    std::vector<uint64_t> hashes;   // stateHash() after steps hashInterval, 2 * hashInterval, ...
+};
+
+class ReplayRecorder {
+public:
+    void begin(const WorldConfig& config, double simHz, int hashInterval = 240);
+    // Call after each GameWorld::step with the input that step used.
+    void record(const GameInput& input, const GameWorld& after);
+    const Replay& replay() const { return data; }
+
+private:
+    Replay data;
+};
+
+// Longest log decodeReplay accepts: a day of play at 240 Hz. Replays come in
+// with bug reports, so a corrupt step count must not be able to ask for
+// gigabytes of inputs.
+const uint64_t kMaxReplaySteps = 240ull * 60 * 60 * 24;
+
+// Binary log: a small header, then the inputs run-length encoded (the paddle
+// sits still for long stretches), then the hashes. Little-endian. Decoding
+// fails on anything truncated, longer than kMaxReplaySteps, or with a world
+// setup GameWorld could not be built from.
+void encodeReplay(const Replay& replay, std::vector<uint8_t>& out);
+bool decodeReplay(const uint8_t* bytes, size_t size, Replay& out);
+bool saveReplay(const std::string& path, const Replay& replay);
+bool loadReplay(const std::string& path, Replay& out);
+
+struct ReplayResult {
+    long long steps = 0;
+    long long mismatchStep = -1;   // step after which the hash first differed, or -1
+    double seconds = 0.0;
+    uint64_t finalHash = 0;
+};
+
+// Steps a fresh world through the log as fast as possible, stopping at the
+// first hash mismatch.
+ReplayResult playReplay(const Replay& replay);
+
+// Command-line entry: plays the file and prints the result.
+int runReplay(const std::string& path);
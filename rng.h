@@ -0,0 +1,88 @@
+#pragma once
+
+#include <glm.hpp>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+// PCG32 (XSH-RR). Each world owns one, so runs are reproducible and threads
+// never share a generator. Generators with the same seed but different
+// stream ids produce independent sequences.
+struct Pcg32 {
+    uint64_t state = 0;
+    uint64_t inc = 1;
+
+    explicit Pcg32(uint64_t seed = 1, uint64_t stream = 0) { reseed(seed, stream); }
+
+    void reseed(uint64_t seed, uint64_t stream = 0) {
+        state = 0;
+        inc = (stream << 1) | 1u;
+        next();
+        state += seed;
+        next();
+    }
+
+    uint32_t next() {
+        uint64_t old = state;
+        state = old * 6364136223846793005ull + inc;
+        uint32_t xorshifted = (uint32_t)(((old >> 18) ^ old) >> 27);
+        uint32_t rot = (uint32_t)(old >> 59);
+        return (xorshifted >> rot) | (xorshifted << ((0u - rot) & 31));
+    }
+
+    // Uniform in [0, n) without modulo bias (Lemire's multiply-shift).
+    uint32_t bounded(uint32_t n) {
+        uint64_t m = (uint64_t)next() * n;
+        uint32_t low = (uint32_t)m;
+        if (low < n) {
+            uint32_t threshold = (0u - n) % n;
+            while (low < threshold) {
+                m = (uint64_t)next() * n;
+                low = (uint32_t)m;
+            }
+        }
+        return (uint32_t)(m >> 32);
+    }
+
+    // Uniform in [0, 1), from the top 24 bits.
+    float uniform() { return (next() >> 8) * (1.0f / 16777216.0f); }
+    float range(float lo, float hi) { return lo + (hi - lo) * uniform(); }
+
+    // A child generator on its own stream, for handing to a worker or a sub-simulation.
+    Pcg32 split() {
+        uint64_t seed = ((uint64_t)next() << 32) | next();
+        uint64_t stream = ((uint64_t)next() << 32) | next();
+        return Pcg32(seed, stream);
+    }
+
+    void fill(uint32_t* out, size_t n) {
+        for (size_t i = 0; i < n; ++i) out[i] = next();
+    }
+    void fillUniform(float* out, size_t n) {
+        for (size_t i = 0; i < n; ++i) out[i] = uniform();
+    }
+    void fillBounded(uint32_t* out, size_t n, uint32_t bound) {
+        for (size_t i = 0; i < n; ++i) out[i] = bounded(bound);
+    }
+};
+
+// Counterparts of glm's gtc/random.hpp helpers, which draw from std::rand.
+inline float linearRand(Pcg32& rng, float lo, float hi) {
+    return rng.range(lo, hi);
+}
+
+inline glm::vec2 linearRand(Pcg32& rng, const glm::vec2& lo, const glm::vec2& hi) {
+    return glm::vec2(rng.range(lo.x, hi.x), rng.range(lo.y, hi.y));
+}
+
+// Uniform point on a circle of the given radius.
+inline glm::vec2 circularRand(Pcg32& rng, float radius) {
+    float a = rng.range(0.0f, 6.28318530718f);
+    return glm::vec2(std::cos(a), std::sin(a)) * radius;
+}
+
+// Uniform point inside a disk of the given radius.
+inline glm::vec2 diskRand(Pcg32& rng, float radius) {
+    return circularRand(rng, radius * std::sqrt(rng.uniform()));
+}
@@ -0,0 +1,137 @@
+#include "sprite_batch.h"
+
+#include <algorithm>
+#include <cstddef>
+
+RenderStats renderStats;
+
+void setupSpriteInstanceAttribs(RenderDevice& device, GLuint vao, GLuint vbo, size_t offset) {
+    device.bindVertexArray(vao);
+    device.bindBuffer(GL_ARRAY_BUFFER, vbo);
+    GLsizei stride = sizeof(SpriteInstance);
+    device.enableVertexAttribArray(2);
+    device.vertexAttribPointer(2, 4, stride, offset + offsetof(SpriteInstance, rect));
+    device.vertexAttribDivisor(2, 1);
+    device.enableVertexAttribArray(3);
+    device.vertexAttribPointer(3, 4, stride, offset + offsetof(SpriteInstance, color));
+    device.vertexAttribDivisor(3, 1);
+    device.enableVertexAttribArray(4);
+    device.vertexAttribPointer(4, 4, stride, offset + offsetof(SpriteInstance, uv));
+    device.vertexAttribDivisor(4, 1);
+    device.bindVertexArray(0);
+}
+
+bool SpriteBatch::init(RenderDevice& dev, GLuint prog, GLuint quadVAO, int cap, int flushesPerFrame) {
+    device = &dev;
+    program = prog;
+    VAO = quadVAO;
+    capacity = cap;
+    loc_projection = device->uniformLocation(program, "projection");
+    loc_tex = device->uniformLocation(program, "tex");
+    pending.reserve(capacity);
+
+    if (!stream.init(*device, (size_t)capacity * sizeof(SpriteInstance) * flushesPerFrame)) return false;
+    setupSpriteInstanceAttribs(*device, VAO, stream.buffer());
+    return true;
+}
+
+void SpriteBatch::begin(const glm::mat4& proj) {
+    pending.clear();
+    currentTex = 0;
+    stream.beginFrame();
+    device->useProgram(program);
+    device->uniformMatrix4(loc_projection, proj);
+    device->uniform1i(loc_tex, 0);
+    renderStats.uniformUploads += 2;
+}
+
+void SpriteBatch::add(const Sprite& s) {
+    if (s.tex != currentTex && !pending.empty()) flush();
+    currentTex = s.tex;
+
+    SpriteInstance inst;
+    inst.rect = glm::vec4(s.pos.x, s.pos.y, s.size.x, s.size.y);
+    inst.color = s.color;
+    inst.uv = s.uv;
+    pending.push_back(inst);
+    if ((int)pending.size() == capacity) flush();
+}
+
+SpriteInstance* SpriteBatch::reserve(GLuint tex, int n) {
+    if ((tex != currentTex || (int)pending.size() + n > capacity) && !pending.empty()) flush();
+    currentTex = tex;
+    size_t at = pending.size();
+    pending.resize(at + n);
+    return pending.data() + at;
+}
+
+void SpriteBatch::flush() {
+    if (pending.empty()) return;
+
+    size_t offset = stream.write(pending.data(), pending.size() * sizeof(SpriteInstance));
+    setupSpriteInstanceAttribs(*device, VAO, stream.buffer(), offset);
+    device->useProgram(program);
+    device->activeTexture(GL_TEXTURE0);
+    device->bindTexture(GL_TEXTURE_2D, currentTex);
+    device->bindVertexArray(VAO);
+    device->drawArraysInstanced(GL_TRIANGLES, 0, 6, (GLsizei)pending.size());
+
+    renderStats.drawCalls++;
+    renderStats.textureBinds++;
+    renderStats.instances += (int)pending.size();
+    pending.clear();
+}
+
+bool BrickInstanceBuffer::init(RenderDevice& dev, GLuint prog, GLuint quadVAO) {
+    device = &dev;
+    program = prog;
+    VAO = quadVAO;
+    instanceVBO = device->createBuffer();
+    setupSpriteInstanceAttribs(*device, VAO, instanceVBO);
+    return instanceVBO != 0;
+}
+
+void BrickInstanceBuffer::upload(const BrickStore& bricks, const SpriteSkin& skin) {
+    tex = skin.tex;
+    count = (int)bricks.count();
+    drawCount = (int)std::min(bricks.count(), bricks.liveEnd());
+    std::vector<SpriteInstance> instances(count);
+    for (int i = 0; i < count; ++i) {
+        SpriteInstance& inst = instances[i];
+        glm::vec2 p = bricks.pos(i), e = bricks.extent(i);
+        inst.rect = bricks.isAlive(i) ? glm::vec4(p.x, p.y, e.x, e.y) : glm::vec4(0.0f);
+        inst.color = bricks.color[i];
+        inst.uv = skin.brick;
+    }
+    device->bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    device->bufferData(GL_ARRAY_BUFFER, count * sizeof(SpriteInstance), instances.data(), GL_DYNAMIC_DRAW);
+    renderStats.bytesUploaded += count * sizeof(SpriteInstance);
+}
+
+void BrickInstanceBuffer::patch(const BrickStore& bricks, const std::vector<int>& killed) {
+    if (killed.empty()) return;
+    drawCount = (int)std::min(bricks.count(), bricks.liveEnd());
+    // A zero-sized rect collapses both triangles, so nothing is rasterised.
+    const glm::vec4 empty(0.0f);
+    device->bindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    for (int brick : killed) {
+        if (brick < 0 || brick >= count) continue;
+        device->bufferSubData(GL_ARRAY_BUFFER, brick * sizeof(SpriteInstance) + offsetof(SpriteInstance, rect),
+            sizeof(glm::vec4), &empty);
+        renderStats.bytesUploaded += sizeof(glm::vec4);
+        patchedInstances++;
+    }
+}
+
+void BrickInstanceBuffer::draw() const {
+    if (drawCount == 0) return;
+    device->useProgram(program);
+    device->activeTexture(GL_TEXTURE0);
+    device->bindTexture(GL_TEXTURE_2D, tex);
+    device->bindVertexArray(VAO);
+    device->drawArraysInstanced(GL_TRIANGLES, 0, 6, drawCount);
+
+    renderStats.drawCalls++;
+    renderStats.textureBinds++;
+    renderStats.instances += drawCount;
+}
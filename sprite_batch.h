@@ -0,0 +1,103 @@
+#pragma once
+
+#include "brick_store.h"
+#include "render_device.h"
+#include "stream_buffer.h"
+
+#include <glad.h>
+#include <glm.hpp>
+
+#include <vector>
+
+struct Sprite {
+    glm::vec2 pos;
+    glm::vec2 size;
+    float rotation = 0.0f;
+    GLuint tex = 0;
+    glm::vec4 uv = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);   // region of tex, see TextureAtlas
+    glm::vec4 color = glm::vec4(1.0f);
+    bool transparent = false;
+    float depth = 0.0f;
+};
+
+// Where each kind of game object lives in the sprite atlas.
+struct SpriteSkin {
+    GLuint tex = 0;
+    glm::vec4 brick = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    glm::vec4 paddle = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    glm::vec4 ball = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+    glm::vec4 heart = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+};
+
+// Per-instance data streamed to the GPU, one entry per sprite.
+struct SpriteInstance {
+    glm::vec4 rect;   // x, y, w, h
+    glm::vec4 color;
+    glm::vec4 uv;     // u0, v0, u1, v1 inside the bound texture
+};
+
+struct RenderStats {
+    int drawCalls = 0;
+    int uniformUploads = 0;
+    int textureBinds = 0;
+    int instances = 0;
+    size_t bytesUploaded = 0;   // vertex and instance data sent to the GPU
+
+    void reset() { *this = RenderStats(); }
+};
+
+extern RenderStats renderStats;
+
+// Points instance attributes 2-4 of `vao` at SpriteInstance entries in `vbo`,
+// starting `offset` bytes in.
+void setupSpriteInstanceAttribs(RenderDevice& device, GLuint vao, GLuint vbo, size_t offset = 0);
+
+// Collects sprites and draws every consecutive run that shares a texture
+// with a single glDrawArraysInstanced call. Instances are appended to a
+// StreamBuffer, so nothing drawn earlier in the frame is overwritten.
+class SpriteBatch {
+public:
+    // A stream chunk holds `flushesPerFrame` full flushes; a frame that flushes
+    // more just moves on to the next chunk.
+    bool init(RenderDevice& device, GLuint program, GLuint quadVAO, int capacity, int flushesPerFrame = 4);
+    void begin(const glm::mat4& proj);
+    void add(const Sprite& s);
+    // Appends n instances of tex to be written in place by the caller, for
+    // producers that already hold instance data. n must fit the capacity.
+    SpriteInstance* reserve(GLuint tex, int n);
+    void flush();
+
+private:
+    RenderDevice* device = nullptr;
+    GLuint program = 0;
+    GLuint VAO = 0;
+    StreamBuffer stream;
+    GLint loc_projection = -1;
+    GLint loc_tex = -1;
+    int capacity = 0;
+    GLuint currentTex = 0;
+    std::vector<SpriteInstance> pending;
+};
+
+// One sprite instance per brick, uploaded when the level is built and kept on
+// the GPU. A brick that dies is patched into an empty rect in place, so the
+// per-frame cost of the whole wall is a single instanced draw.
+class BrickInstanceBuffer {
+public:
+    bool init(RenderDevice& device, GLuint program, GLuint quadVAO);
+    void upload(const BrickStore& bricks, const SpriteSkin& skin);
+    void patch(const BrickStore& bricks, const std::vector<int>& killed);
+    // Shares the sprite program; call after SpriteBatch::begin has set the projection.
+    void draw() const;
+
+    int patchedInstances = 0;
+
+private:
+    RenderDevice* device = nullptr;
+    GLuint program = 0;
+    GLuint VAO = 0;
+    GLuint instanceVBO = 0;
+    GLuint tex = 0;
+    int count = 0;
+    int drawCount = 0;   // instances past the last live chunk are skipped
+};
@@ -0,0 +1,69 @@
+#include "stream_buffer.h"
+#include "sprite_batch.h"
+
+#include <cstring>
+
+namespace {
+
+// Offsets stay aligned for any vertex attribute type.
+const size_t kWriteAlign = 16;
+
+}
+
+bool StreamBuffer::init(RenderDevice& dev, size_t bytes) {
+    device = &dev;
+    chunkBytes = (bytes + kWriteAlign - 1) / kWriteAlign * kWriteAlign;
+    size_t total = chunkBytes * kChunks;
+    vbo = device->createBuffer();
+    device->bindBuffer(GL_ARRAY_BUFFER, vbo);
+    mapped = (unsigned char*)device->bufferStoragePersistent(GL_ARRAY_BUFFER, total);
+    if (!mapped) device->bufferData(GL_ARRAY_BUFFER, total, nullptr, GL_STREAM_DRAW);
+    return vbo != 0;
+}
+
+void StreamBuffer::nextChunk() {
+    if (mapped) {
+        fences[chunk] = device->fence();
+        chunk = (chunk + 1) % kChunks;
+        if (fences[chunk]) {
+            if (!device->waitFence(fences[chunk], 1000000000ull)) fenceWaits++;
+            device->deleteFence(fences[chunk]);
+            fences[chunk] = nullptr;
+        }
+    }
+    else {
+        chunk = (chunk + 1) % kChunks;
+        if (chunk == 0) {
+            device->bindBuffer(GL_ARRAY_BUFFER, vbo);
+            device->bufferData(GL_ARRAY_BUFFER, chunkBytes * kChunks, nullptr, GL_STREAM_DRAW);
+        }
+    }
+    used = 0;
+}
+
+void StreamBuffer::beginFrame() {
+    if (used > 0) nextChunk();
+}
+
+size_t StreamBuffer::write(const void* data, size_t bytes) {
+    if (used + bytes > chunkBytes) nextChunk();
+    size_t offset = (size_t)chunk * chunkBytes + used;
+    device->bindBuffer(GL_ARRAY_BUFFER, vbo);
+    if (mapped) {
+        std::memcpy(mapped + offset, data, bytes);
+    }
+    else {
+        const GLbitfield access = GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT;
+        void* dst = device->mapBufferRange(GL_ARRAY_BUFFER, offset, bytes, access);
+        if (dst) {
+            std::memcpy(dst, data, bytes);
+            device->unmapBuffer(GL_ARRAY_BUFFER);
+        }
+        else {
+            device->bufferSubData(GL_ARRAY_BUFFER, offset, bytes, data);
+        }
+    }
+    used += (bytes + kWriteAlign - 1) / kWriteAlign * kWriteAlign;
+    renderStats.bytesUploaded += bytes;
+    return offset;
+}
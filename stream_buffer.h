@@ -0,0 +1,44 @@
+#pragma once
+
+#include "render_device.h"
+
+#include <glad.h>
+
+#include <cstddef>
+
+// Ring of kChunks equal chunks in one GL_ARRAY_BUFFER that per-frame vertex
+// and instance data is appended to. Each frame starts a new chunk, as does a
+// write that no longer fits.
+//
+// On GL 4.4 the buffer is mapped once, persistently and coherently. A chunk is
+// fenced when it is left behind, and waited on before it is reused, so with
+// three chunks the CPU fills one while the GPU may still read the other two.
+// On GL 3.3 each write maps its range unsynchronized; the buffer is orphaned
+// whenever the ring wraps, so no range is rewritten while a draw may read it.
+class StreamBuffer {
+public:
+    static const int kChunks = 3;
+
+    // `chunkBytes` bounds a single write.
+    bool init(RenderDevice& device, size_t chunkBytes);
+    void beginFrame();
+    // Copies `bytes` in and returns their offset in buffer(). The buffer is
+    // left bound to GL_ARRAY_BUFFER.
+    size_t write(const void* data, size_t bytes);
+
+    GLuint buffer() const { return vbo; }
+    bool persistent() const { return mapped != nullptr; }
+
+    int fenceWaits = 0;   // reused chunks the GPU had not finished with yet
+
+private:
+    void nextChunk();
+
+    RenderDevice* device = nullptr;
+    GLuint vbo = 0;
+    unsigned char* mapped = nullptr;
+    size_t chunkBytes = 0;
+    int chunk = 0;
+    size_t used = 0;
+    GLsync fences[kChunks] = {};
+};
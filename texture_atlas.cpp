@@ -0,0 +1,165 @@
+#include "texture_atlas.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+
+namespace {
+
+const int kAtlasPadding = 4;
+// Regions are 2 * kAtlasPadding texels apart, so the first kAtlasMaxLevel mip levels never
+// blend neighbouring sprites together.
+const int kAtlasMaxLevel = 2;
+
+size_t mipChainBytes(int w, int h, int maxLevel) {
+    size_t bytes = 0;
+    for (int level = 0; level <= maxLevel; ++level) {
+        bytes += (size_t)w * h * 4;
+        if (w == 1 && h == 1) break;
+        w = std::max(1, w / 2);
+        h = std::max(1, h / 2);
+    }
+    return bytes;
+}
+
+}
+
+void packAtlas(const std::vector<AtlasImage>& images, int padding, TextureAtlas& atlas,
+    std::vector<unsigned char>& pixels)
+{
+    atlas.regions.assign(images.size(), AtlasRegion());
+    atlas.imagePixels = 0;
+    atlas.separateBytes = 0;
+
+    int maxW = 1;
+    for (const auto& img : images) {
+        maxW = std::max(maxW, img.w + 2 * padding);
+        atlas.imagePixels += (size_t)img.w * img.h;
+        atlas.separateBytes += mipChainBytes(img.w, img.h, 32);
+    }
+
+    // Tallest first onto shelves that fill left to right.
+    std::vector<size_t> order(images.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return images[a].h > images[b].h; });
+
+    auto layout = [&](int width, bool place) {
+        int shelfX = 0, shelfY = 0, shelfH = 0;
+        for (size_t idx : order) {
+            int w = images[idx].w + 2 * padding, h = images[idx].h + 2 * padding;
+            if (shelfX + w > width) {
+                shelfY += shelfH;
+                shelfX = 0;
+                shelfH = 0;
+            }
+            if (place) {
+                AtlasRegion& r = atlas.regions[idx];
+                r.x = shelfX + padding;
+                r.y = shelfY + padding;
+                r.w = images[idx].w;
+                r.h = images[idx].h;
+            }
+            shelfX += w;
+            shelfH = std::max(shelfH, h);
+        }
+        return std::max(4, (shelfY + shelfH + 3) / 4 * 4);
+    };
+
+    // The sprite set is tiny, so simply try every width and keep the smallest area.
+    int sumW = 0;
+    for (const auto& img : images) sumW += img.w + 2 * padding;
+    int width = (maxW + 3) / 4 * 4;
+    size_t bestArea = (size_t)-1;
+    for (int w = width; w <= std::max(width, sumW + 3); w += 4) {
+        size_t a = (size_t)w * layout(w, false);
+        if (a < bestArea) {
+            bestArea = a;
+            width = w;
+        }
+    }
+    int height = layout(width, true);
+
+    atlas.width = width;
+    atlas.height = height;
+    atlas.maxLevel = kAtlasMaxLevel;
+    atlas.atlasBytes = mipChainBytes(width, height, kAtlasMaxLevel);
+
+    pixels.assign((size_t)width * height * 4, 0);
+    for (size_t i = 0; i < images.size(); ++i) {
+        const AtlasImage& img = images[i];
+        AtlasRegion& r = atlas.regions[i];
+        // Copy with the border texels repeated into the padding.
+        for (int y = -padding; y < img.h + padding; ++y) {
+            int sy = std::min(std::max(y, 0), img.h - 1);
+            for (int x = -padding; x < img.w + padding; ++x) {
+                int sx = std::min(std::max(x, 0), img.w - 1);
+                std::memcpy(&pixels[((size_t)(r.y + y) * width + (r.x + x)) * 4], &img.rgba[((size_t)sy * img.w + sx) * 4], 4);
+            }
+        }
+        r.uv = glm::vec4((float)r.x / width, (float)r.y / height,
+            (float)(r.x + r.w) / width, (float)(r.y + r.h) / height);
+    }
+}
+
+void buildAtlas(const std::vector<std::string>& paths, TextureAtlas& atlas, std::vector<unsigned char>& pixels) {
+    std::vector<AtlasImage> images(paths.size());
+    // The per-thread flag, so loader threads do not race on stb's global.
+    stbi_set_flip_vertically_on_load_thread(true);
+    for (size_t i = 0; i < paths.size(); ++i) {
+        int w, h, channels;
+        unsigned char* data = stbi_load(paths[i].c_str(), &w, &h, &channels, 4);
+        AtlasImage& img = images[i];
+        if (!data) {
+            std::cout << "Failed to load texture: " << paths[i] << std::endl;
+            img.w = img.h = 4;
+            img.rgba.assign(4 * 4 * 4, 255);
+            continue;
+        }
+        img.w = w;
+        img.h = h;
+        img.rgba.assign(data, data + (size_t)w * h * 4);
+        stbi_image_free(data);
+    }
+    packAtlas(images, kAtlasPadding, atlas, pixels);
+}
+
+TextureAtlas bakeAtlas(const std::vector<std::string>& paths) {
+    TextureAtlas atlas;
+    std::vector<unsigned char> pixels;
+    buildAtlas(paths, atlas, pixels);
+
+    glGenTextures(1, &atlas.tex);
+    glBindTexture(GL_TEXTURE_2D, atlas.tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, atlas.width, atlas.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, atlas.maxLevel);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+    describeAtlas(atlas, paths.size());
+    return atlas;
+}
+
+void describeAtlas(const TextureAtlas& atlas, size_t imageCount) {
+    std::cout << "Atlas " << atlas.width << "x" << atlas.height << ", " << imageCount << " images, "
+        << (int)(atlas.packingEfficiency() * 100.0f + 0.5f) << "% packed, "
+        << atlas.atlasBytes / 1024 << " KiB vs " << atlas.separateBytes / 1024 << " KiB as separate textures ("
+        << ((long long)atlas.separateBytes - (long long)atlas.atlasBytes) / 1024 << " KiB saved, 1 bind instead of "
+        << imageCount << ")" << std::endl;
+}
+
+GLuint makePlaceholderTexture() {
+    const std::vector<unsigned char> white(4 * 4 * 4, 255);
+    GLuint tex;
+    glGenTextures(1, &tex);
+    glBindTexture(GL_TEXTURE_2D, tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 4, 4, 0, GL_RGBA, GL_UNSIGNED_BYTE, white.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    return tex;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <glad.h>
+#include <glm.hpp>
+
+#include <string>
+#include <vector>
+
+struct AtlasRegion {
+    int x = 0, y = 0, w = 0, h = 0;
+    glm::vec4 uv = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);   // u0, v0, u1, v1
+};
+
+struct AtlasImage {
+    int w = 0, h = 0;
+    std::vector<unsigned char> rgba;
+};
+
+// All sprite images packed into one RGBA texture, so a whole frame can be
+// drawn with a single texture bind. Regions follow the order of the inputs.
+struct TextureAtlas {
+    GLuint tex = 0;
+    int width = 0, height = 0;
+    int maxLevel = 0;            // highest mip level that keeps regions apart
+    std::vector<AtlasRegion> regions;
+
+    size_t imagePixels = 0;      // sum of the packed images, without padding
+    size_t separateBytes = 0;    // VRAM the images would take as separate mipmapped textures
+    size_t atlasBytes = 0;       // VRAM the atlas takes, including its mip levels
+
+    float packingEfficiency() const { return width > 0 && height > 0 ? (float)imagePixels / (width * height) : 0.0f; }
+};
+
+// Shelf-packs the images with `padding` texels of edge extrusion around each
+// one. Fills in the layout and byte counts, and the packed RGBA pixels.
+void packAtlas(const std::vector<AtlasImage>& images, int padding, TextureAtlas& atlas,
+    std::vector<unsigned char>& pixels);
+
+// The CPU half of bakeAtlas: loads the PNGs and packs them, leaving the
+// texture to the caller. An image that fails to load is packed as a small
+// white square so its sprites still draw. Safe to call off the main thread.
+void buildAtlas(const std::vector<std::string>& paths, TextureAtlas& atlas, std::vector<unsigned char>& pixels);
+
+// Loads, packs and uploads the atlas.
+TextureAtlas bakeAtlas(const std::vector<std::string>& paths);
+
+// Prints the packing summary for an atlas built from `imageCount` images.
+void describeAtlas(const TextureAtlas& atlas, size_t imageCount);
+
+// A 4x4 white texture to draw with until the real one is resident.
+GLuint makePlaceholderTexture();
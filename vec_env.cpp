@@ -0,0 +1,104 @@
+#include "vec_env.h"
+
+#include <algorithm>
+
+VecEnv::VecEnv(const VecEnvConfig& cfg, JobSystem* js) : config(cfg), jobs(js) {
+    int n = std::max(1, cfg.numEnvs);
+    worlds.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        WorldConfig wc = cfg.world;
+        wc.stream = (uint32_t)i;
+        worlds.emplace_back(wc);
+    }
+    obs.assign((size_t)OBS_COUNT * n, 0.0f);
+    reward.assign(n, 0.0f);
+    done.assign(n, 0);
+    lastScore.assign(n, 0);
+    lastLives.assign(n, 0);
+    reset();
+}
+
+void VecEnv::reset() {
+    for (size_t i = 0; i < worlds.size(); ++i) {
+        worlds[i].reset();
+        lastScore[i] = worlds[i].score;
+        lastLives[i] = worlds[i].lives;
+    }
+    std::fill(reward.begin(), reward.end(), 0.0f);
+    std::fill(done.begin(), done.end(), 0);
+    observeRange(0, worlds.size());
+}
+
+void VecEnv::step(const float* actions) {
+    size_t n = worlds.size();
+    if (!jobs) {
+        stepRange(0, n, actions);
+        return;
+    }
+    // A few chunks per thread leaves room for stealing when some envs run multiball.
+    size_t grain = std::max<size_t>(16, n / (jobs->threadCount() * 8));
+    jobs->parallelFor(n, grain, [&](size_t begin, size_t end) { stepRange(begin, end, actions); });
+}
+
+void VecEnv::stepRange(size_t begin, size_t end, const float* actions) {
+    const float dt = (float)(1.0 / config.simHz);
+    for (size_t i = begin; i < end; ++i) {
+        GameWorld& w = worlds[i];
+        GameInput input;
+        input.paddleX = std::min(std::max(actions[i], 0.0f), 1.0f) * w.config.width;
+        for (int s = 0; s < config.stepsPerAction && !w.gameOver && !w.youWin; ++s)
+            w.step(dt, input);
+
+        // +1 per brick, -1 per life lost (extra lives from power-ups count back).
+        reward[i] = (float)(w.score - lastScore[i]) / w.config.brickPoints + (float)(w.lives - lastLives[i]);
+        done[i] = (w.gameOver || w.youWin) ? 1 : 0;
+        if (done[i]) w.reset();
+        lastScore[i] = w.score;
+        lastLives[i] = w.lives;
+    }
+    observeRange(begin, end);
+
+    size_t finished = 0;
+    for (size_t i = begin; i < end; ++i) finished += done[i];
+    if (finished) finishedEpisodes.fetch_add((long long)finished, std::memory_order_relaxed);
+}
+
+void VecEnv::observeRange(size_t begin, size_t end) {
+    const size_t n = worlds.size();
+    float* paddleX = &obs[OBS_PADDLE_X * n];
+    float* ballX = &obs[OBS_BALL_X * n];
+    float* ballY = &obs[OBS_BALL_Y * n];
+    float* ballVx = &obs[OBS_BALL_VX * n];
+    float* ballVy = &obs[OBS_BALL_VY * n];
+    float* balls = &obs[OBS_BALLS * n];
+    float* lives = &obs[OBS_LIVES * n];
+    float* bricksLeft = &obs[OBS_BRICKS_LEFT * n];
+
+    // Gather raw values; the lowest ball is the one that matters to the paddle.
+    for (size_t i = begin; i < end; ++i) {
+        const GameWorld& w = worlds[i];
+        paddleX[i] = w.paddle.pos.x + w.paddle.size.x * 0.5f;
+        const Ball* low = nullptr;
+        for (const auto& b : w.balls)
+            if (!low || b.pos.y < low->pos.y) low = &b;
+        ballX[i] = low ? low->pos.x : 0.0f;
+        ballY[i] = low ? low->pos.y : 0.0f;
+        ballVx[i] = low ? low->vel.x : 0.0f;
+        ballVy[i] = low ? low->vel.y : 0.0f;
+        balls[i] = (float)w.balls.size();
+        lives[i] = (float)w.lives;
+        bricksLeft[i] = (float)w.bricks.liveCount() / std::max<size_t>(1, w.bricks.count());
+    }
+
+    // Normalise feature rows in place; plain contiguous loops, so they vectorise.
+    const WorldConfig& wc = config.world;
+    const float invW = 1.0f / wc.width, invH = 1.0f / wc.height, invV = 1.0f / 1000.0f;
+    const float invLives = 1.0f / std::max(1, wc.lives);
+    for (size_t i = begin; i < end; ++i) paddleX[i] *= invW;
+    for (size_t i = begin; i < end; ++i) ballX[i] *= invW;
+    for (size_t i = begin; i < end; ++i) ballY[i] *= invH;
+    for (size_t i = begin; i < end; ++i) ballVx[i] *= invV;
+    for (size_t i = begin; i < end; ++i) ballVy[i] *= invV;
+    for (size_t i = begin; i < end; ++i) balls[i] *= 0.125f;
+    for (size_t i = begin; i < end; ++i) lives[i] *= invLives;
+}
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "game_world.h"
+#include "job_system.h"
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+struct VecEnvConfig {
+    int numEnvs = 1024;
+    int stepsPerAction = 4;   // fixed simulation steps per env step (60 Hz agent on a 240 Hz sim)
+    double simHz = 240.0;
+    WorldConfig world;        // world.seed is shared; each env gets its own stream
+};
+
+// N independent worlds stepped together, for reinforcement learning. Results
+// come back as flat structure-of-arrays buffers: feature f of env i is
+// observations()[f * size() + i]. Finished envs are reset automatically and
+// their observation is the first one of the new episode.
+//
+// Only the results are SoA. The worlds are whole GameWorlds side by side,
+// not split field by field across envs with SIMD lanes over them: balls,
+// power-ups and bricks live in variable-sized pools, and a world branches
+// on every collision, so lanes would diverge at once and GameWorld would
+// need rewriting around fixed-size state. The batch gets its speed from
+// stepping worlds in parallel on the job system instead.
+class VecEnv {
+public:
+    enum Feature {
+        OBS_PADDLE_X,
+        OBS_BALL_X,
+        OBS_BALL_Y,
+        OBS_BALL_VX,
+        OBS_BALL_VY,
+        OBS_BALLS,
+        OBS_LIVES,
+        OBS_BRICKS_LEFT,
+        OBS_COUNT
+    };
+
+    // Without a job system the envs are stepped on the calling thread.
+    explicit VecEnv(const VecEnvConfig& cfg, JobSystem* jobs = nullptr);
+
+    void reset();
+    // One action per env: the paddle centre as a fraction of the field width.
+    void step(const float* actions);
+
+    int size() const { return (int)worlds.size(); }
+    const float* observations() const { return obs.data(); }
+    const float* rewards() const { return reward.data(); }
+    const uint8_t* dones() const { return done.data(); }
+    const GameWorld& world(int i) const { return worlds[i]; }
+    long long episodes() const { return finishedEpisodes.load(std::memory_order_relaxed); }
+
+private:
+    void stepRange(size_t begin, size_t end, const float* actions);
+    void observeRange(size_t begin, size_t end);
+
+    VecEnvConfig config;
+    JobSystem* jobs;
+    std::vector<GameWorld> worlds;
+    std::vector<float> obs;
+    std::vector<float> reward;
+    std::vector<uint8_t> done;
+    std::vector<int> lastScore, lastLives;
+    std::atomic<long long> finishedEpisodes{ 0 };
+};